@@ -2,19 +2,56 @@
 
 #include "../io/BmpReader.h"
 #include "../io/MdeReader.h"
+#include "../io/MtcReader.h"
 
 #include "../graphics/Texture.h"
 
 #include "Cache.h"
 
+#include <filesystem>
+
 namespace Assets {
+    static bool load_mtc_texture(Cache &cache, const std::string &name, AssetData &&data) {
+        MtcView view;
+
+        if (!read_mtc(data.data, data.size, view) || view.levels.empty())
+            return false;
+
+        // the levels point into the mapped file or archive, nothing is decoded or filtered
+        Graphics::MipTexturesList mip_textures;
+
+        for (const auto &level : view.levels)
+            mip_textures.push_back(std::make_unique<Graphics::Texture>(level.width, level.height, level.pixels));
+
+        cache.set_textures(name, std::move(mip_textures));
+        cache.keep_asset_data(name, std::move(data));
+
+        return true;
+    }
+
     bool load_texture(Cache &cache, const std::string &filename, const AssetOptions &options) {
+        // a container next to the bmp already holds the whole mip chain
+        auto mtc_name = std::filesystem::path(filename).replace_extension(".mtc").string();
+
+        AssetData mtc_data;
+        if (cache.open_asset(mtc_name, mtc_data) && load_mtc_texture(cache, filename, std::move(mtc_data)))
+            return true;
+
+        AssetData data;
+        if (!cache.open_asset(filename, data)) {
+            throw std::runtime_error("Could not load bmp from file");
+        }
+
         BmpReader reader;
 
         Graphics::MipTexturesList mip_textures;
 
+        // the first mip level comes out of the decode pass when the size allows it
+        std::unique_ptr<Graphics::Texture> mip_level_1;
+
         auto root_texture = new Graphics::Texture();
-        if (!root_texture->load_from_bmp(filename)) {
+        if (!root_texture->load_from_bmp(data.data, data.size, &mip_level_1, 1.01f)) {
+            delete root_texture;
             throw std::runtime_error("Could not load bmp from file");
         }
 
@@ -22,7 +59,10 @@ namespace Assets {
 
         auto mip_levels = std::log(root_texture->width) / std::log(2) + 1;
 
-        for (int mip_level = 1; mip_level < mip_levels; mip_level++) {
+        if (mip_level_1 && mip_levels > 1)
+            mip_textures.push_back(std::move(mip_level_1));
+
+        for (int mip_level = mip_textures.size(); mip_level < mip_levels; mip_level++) {
             auto quarter_texture = mip_textures[mip_level - 1]->quarter_size(1.01f);
             mip_textures.push_back(std::move(quarter_texture));
         }
@@ -72,11 +112,100 @@ namespace Assets {
         return 1;
     }
 
+    static bool load_mde_v2(Cache &cache, const std::string &filename, const AssetOptions &options,
+            const AssetData &data)
+    {
+        MdeView view;
+        if (!read_mde_v2(data.data, data.size, view))
+            return false;
+
+        auto &header = *view.header;
+        auto mesh = new Graphics::Mesh {};
+
+        for (int i = 0; i < header.num_skins; i++)
+            mesh->skins.push_back(std::string(view.skins[i], strnlen(view.skins[i], 64)));
+
+        mesh->frames_count = header.num_frames;
+
+        mesh->vertex_count = header.num_verts;
+        mesh->text_count = header.num_textcoords;
+        mesh->radius = header.radius;
+
+        int verts_amount = header.num_verts * header.num_frames;
+
+        mesh->vertices = new Graphics::Vertex4D[verts_amount];
+        mesh->text_coords = new Graphics::Point2D[header.num_textcoords];
+
+        // The pipeline works on Vertex4D, so the mapped arrays are interleaved once here.
+        // Normals, face normals and bounds come from the file.
+        for (int ivert = 0; ivert < verts_amount; ivert++) {
+            auto &vert = mesh->vertices[ivert];
+
+            vert.v = V4D {view.positions[0][ivert], view.positions[1][ivert], view.positions[2][ivert], 0};
+            vert.n = V4D {view.normals[0][ivert], view.normals[1][ivert], view.normals[2][ivert]};
+            vert.attributes = Graphics::VertexAttributePoint;
+        }
+
+        for (int itext = 0; itext < header.num_textcoords; itext++)
+            mesh->text_coords[itext] = Graphics::Point2D {view.text_coords[0][itext], view.text_coords[1][itext]};
+
+        for (int iblock = 0; iblock < header.num_blocks; iblock++) {
+            auto &block = view.blocks[iblock];
+
+            std::vector<Graphics::Polygon> polygons;
+            polygons.reserve(block.num_polys);
+
+            for (int ipoly = 0; ipoly < block.num_polys; ipoly++) {
+                Graphics::Polygon polygon;
+
+                polygon.vertices = mesh->vertices;
+                polygon.text_coords = mesh->text_coords;
+
+                polygon.state = options.mesh_options.poly_state;
+                polygon.attributes = options.mesh_options.poly_attributes;
+                polygon.color = options.mesh_options.poly_color;
+
+                for (int j = 0; j < 3; j++) {
+                    polygon.vert[j] = block.vertex_indices[ipoly * 3 + j];
+
+                    if (header.num_textcoords > 0) {
+                        polygon.text[j] = block.text_indices[ipoly * 3 + j];
+
+                        mesh->vertices[polygon.vert[j]].t = mesh->text_coords[polygon.text[j]];
+                        mesh->vertices[polygon.vert[j]].attributes |= Graphics::VertexAttributeTexture;
+                    }
+                }
+
+                polygon.normal = V4D {block.face_normals[0][ipoly], block.face_normals[1][ipoly], block.face_normals[2][ipoly]};
+                polygon.n_length = polygon.normal.length();
+
+                polygons.push_back(polygon);
+            }
+
+            if (iblock == 0)
+                mesh->polygons = std::move(polygons);
+            else
+                mesh->lods.push_back(std::move(polygons));
+        }
+
+        cache.set_mesh(filename, std::unique_ptr<Graphics::Mesh>(mesh));
+
+        return true;
+    }
+
     bool load_mde_file(Cache &cache, const std::string &filename, const AssetOptions &options) {
+        AssetData data;
+        if (!cache.open_asset(filename, data))
+            return false;
+
+        if (mde_version(data.data, data.size) == MdeVersion2)
+            return load_mde_v2(cache, filename, options, data);
+
         MdeReader reader;
 
         MdeFile file;
-        reader.read_file(filename, file);
+        if (!reader.read_memory(data.data, data.size, file))
+            return false;
 
         auto mesh = new Graphics::Mesh {};
 
@@ -111,54 +240,68 @@ namespace Assets {
 
         auto polys_ptr = file.polys.get();
 
-        for (int iframe = 0; iframe < file.header.num_frames; iframe++) {
-            for (int ipoly = 0; ipoly < file.header.num_polys; ipoly++) {
-                Graphics::Polygon polygon;
-                auto mde_poly = polys_ptr[ipoly];
-
-                polygon.vertices = mesh->vertices;
-                polygon.text_coords = mesh->text_coords;
+        auto make_polygon = [&](const MdePoly &mde_poly) {
+            Graphics::Polygon polygon;
 
-                for (int j = 0; j < 3; j++) {
-                    polygon.vert[j] = mde_poly.v_index[j];
-                    polygon.state = options.mesh_options.poly_state;
+            polygon.vertices = mesh->vertices;
+            polygon.text_coords = mesh->text_coords;
 
-                    polygon.attributes = options.mesh_options.poly_attributes;
+            for (int j = 0; j < 3; j++) {
+                polygon.vert[j] = mde_poly.v_index[j];
+                polygon.state = options.mesh_options.poly_state;
 
-                    if (file.header.num_textcoords > 0) {
-                        polygon.vertices[mde_poly.v_index[j] * file.header.num_frames].t = mesh->text_coords[mde_poly.t_index[j]];
+                polygon.attributes = options.mesh_options.poly_attributes;
 
-                        polygon.text[j] = mde_poly.t_index[j];
-                        polygon.vertices[mde_poly.v_index[j] * file.header.num_frames].attributes |= Graphics::VertexAttributeTexture;
-                    }
+                if (file.header.num_textcoords > 0) {
+                    polygon.vertices[mde_poly.v_index[j] * file.header.num_frames].t = mesh->text_coords[mde_poly.t_index[j]];
 
-                    // TODO extract the normal indices
+                    polygon.text[j] = mde_poly.t_index[j];
+                    polygon.vertices[mde_poly.v_index[j] * file.header.num_frames].attributes |= Graphics::VertexAttributeTexture;
                 }
 
-                if (polygon.attributes & Graphics::PolyAttributeShadeModeGouraud ||
-                        polygon.attributes & Graphics::PolyAttributeShadeModeIntensityGourad) {
+                // TODO extract the normal indices
+            }
 
-                    auto line1 = mesh->vertices[polygon.vert[0]].v
-                        - mesh->vertices[polygon.vert[1]].v;
+            // face normals are stored in object space so backface culling can happen
+            // before any vertex is transformed
+            auto line1 = mesh->vertices[polygon.vert[0]].v
+                - mesh->vertices[polygon.vert[1]].v;
 
-                    auto line2 = mesh->vertices[polygon.vert[0]].v
-                        - mesh->vertices[polygon.vert[2]].v;
+            auto line2 = mesh->vertices[polygon.vert[0]].v
+                - mesh->vertices[polygon.vert[2]].v;
 
-                    polygon.n_length = line1.cross(line2).length();
-                    polygon.text_coords = mesh->text_coords;
-                }
+            polygon.normal = line1.cross(line2);
+            polygon.n_length = polygon.normal.length();
 
-                polygon.color = options.mesh_options.poly_color;
+            polygon.color = options.mesh_options.poly_color;
 
-                polygons.push_back(polygon);
+            return polygon;
+        };
+
+        for (int iframe = 0; iframe < file.header.num_frames; iframe++) {
+            for (int ipoly = 0; ipoly < file.header.num_polys; ipoly++) {
+                polygons.push_back(make_polygon(polys_ptr[ipoly]));
             }
         }
 
         mesh->polygons = polygons;
 
+        for (const auto &mde_lod : file.lods) {
+            std::vector<Graphics::Polygon> lod;
+
+            for (const auto &mde_poly : mde_lod)
+                lod.push_back(make_polygon(mde_poly));
+
+            mesh->lods.push_back(std::move(lod));
+        }
+
         // TODO: add way for checking normals
         compute_vertex_normals(*mesh);
 
+        // the bounding sphere has to hold every frame of the animation
+        for (int vertex = 0; vertex < mesh->vertex_count * mesh->frames_count; vertex++)
+            mesh->radius = std::max(mesh->radius, mesh->vertices[vertex].v.length());
+
         cache.set_mesh(filename, std::unique_ptr<Graphics::Mesh>(mesh));
 
         return true;
@@ -1,42 +1,193 @@
 #include "Cache.h"
 
+#include "../io/Logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
 namespace Assets {
-    Cache::Cache() {
+    Cache::Cache(Core::JobSystem *job_system) : p_job_system(job_system) {
         m_loaders.push_back(std::make_pair(Asset::Type::Texture, &load_texture));
         m_loaders.push_back(std::make_pair(Asset::Type::Mde, &load_mde_file));
     }
 
     Cache::~Cache() {
+        // the jobs write into their staging caches and m_finished
+        if (p_job_system != nullptr)
+            p_job_system->wait(m_load_jobs);
     }
 
     void Cache::load_asset(Asset::Type asset_type, const std::string &filename,
             const AssetOptions &options)
     {
+        run_loader(asset_type, filename, options);
+    }
+
+    bool Cache::run_loader(Asset::Type asset_type, const std::string &filename, const AssetOptions &options) {
+        bool success = false;
+
         for (auto loader : m_loaders) {
             if (loader.first == asset_type) {
-                loader.second(*this, filename, options);
+                success = loader.second(*this, filename, options);
             }
         }
+
+        return success;
+    }
+
+    AssetHandle Cache::load_asset_async(Asset::Type asset_type, const std::string &filename,
+            const AssetOptions &options, LoadCallback callback)
+    {
+        auto pending = m_pending.find(filename);
+        if (pending != m_pending.end()) {
+            if (callback)
+                pending->second->callbacks.push_back(std::move(callback));
+
+            return AssetHandle(pending->second);
+        }
+
+        auto load = std::make_shared<AsyncLoad>();
+        load->type = asset_type;
+        load->filename = filename;
+        load->options = options;
+
+        if (callback)
+            load->callbacks.push_back(std::move(callback));
+
+        m_pending.insert(std::make_pair(filename, load));
+
+        bool loaded = asset_type == Asset::Type::Texture ? m_textures.count(filename) > 0 : m_meshes.count(filename) > 0;
+
+        if (loaded) {
+            // nothing to decode, the callback still runs from update like for every other load
+            load->success = true;
+
+            std::lock_guard<std::mutex> lock(m_finished_mutex);
+            m_finished.push_back(load);
+        } else {
+            // set up on this thread, so a later mount doesn't race with the job
+            load->staging = std::make_unique<Cache>();
+            load->staging->m_archives = m_archives;
+
+            if (p_job_system != nullptr && p_job_system->get_num_threads() > 1) {
+                p_job_system->submit_background([this, load] {
+                    run_async_load(load);
+                }, &m_load_jobs);
+            } else {
+                run_async_load(load);
+            }
+        }
+
+        return AssetHandle(load);
+    }
+
+    void Cache::run_async_load(const std::shared_ptr<AsyncLoad> &load) {
+        try {
+            load->success = load->staging->run_loader(load->type, load->filename, load->options);
+        } catch (const std::exception &) {
+            load->success = false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_finished_mutex);
+        m_finished.push_back(load);
+    }
+
+    void Cache::update() {
+        std::vector<std::shared_ptr<AsyncLoad>> finished;
+
+        {
+            std::lock_guard<std::mutex> lock(m_finished_mutex);
+            finished.swap(m_finished);
+        }
+
+        for (auto &load : finished) {
+            if (load->staging)
+                merge(std::move(*load->staging));
+
+            load->staging.reset();
+            m_pending.erase(load->filename);
+
+            load->state.store(load->success ? LoadState::Loaded : LoadState::Failed, std::memory_order_release);
+
+            // the callback may only start another load, the asset has to wait for its acquire
+            auto entry = m_entries.find(load->filename);
+            if (load->success && entry != m_entries.end())
+                entry->second.pinned = true;
+
+            for (auto &callback : load->callbacks)
+                callback(load->filename, load->success);
+
+            load->callbacks.clear();
+        }
+
+        if (!finished.empty())
+            enforce_budget();
+    }
+
+    void Cache::merge(Cache &&other) {
+        for (auto &pair : other.m_meshes)
+            set_mesh(pair.first, std::move(pair.second));
+
+        for (auto &pair : other.m_textures) {
+            // loaded twice, the textures already in the cache still point into the old mapping
+            if (m_textures.count(pair.first) > 0) {
+                other.m_asset_data.erase(pair.first);
+                continue;
+            }
+
+            set_textures(pair.first, std::move(pair.second));
+        }
+
+        // the mappings don't move in memory, textures that point into them stay valid
+        for (auto &pair : other.m_asset_data)
+            m_asset_data[pair.first] = std::move(pair.second);
+
+        other.m_meshes.clear();
+        other.m_textures.clear();
+        other.m_asset_data.clear();
+        other.m_entries.clear();
+        other.m_memory_used = 0;
+    }
+
+    static size_t texture_bytes(const Graphics::Texture &texture) {
+        return sizeof(Graphics::Texture) + texture.width * texture.height * sizeof(uint32_t);
+    }
+
+    static size_t mesh_bytes(const Graphics::Mesh &mesh) {
+        size_t bytes = sizeof(Graphics::Mesh);
+
+        bytes += mesh.vertex_count * mesh.frames_count * sizeof(Graphics::Vertex4D);
+        bytes += mesh.text_count * sizeof(Graphics::Point2D);
+        bytes += mesh.polygons.size() * sizeof(Graphics::Polygon);
+
+        for (const auto &lod : mesh.lods)
+            bytes += lod.size() * sizeof(Graphics::Polygon);
+
+        return bytes;
     }
 
     Graphics::Mesh* Cache::get_mesh(std::string name) const {
         auto pair = m_meshes.find(name);
+        if (pair == m_meshes.end())
+            return nullptr;
 
         return pair->second.get();
     }
 
     void Cache::set_mesh(std::string name, std::unique_ptr<Graphics::Mesh> mesh) {
-        m_meshes.insert(std::make_pair(name, std::move(mesh)));
-    }
+        size_t bytes = mesh_bytes(*mesh);
 
-    void Cache::release_mesh(std::string name) {
-        m_meshes.erase(name);
+        if (m_meshes.insert(std::make_pair(name, std::move(mesh))).second)
+            add_entry(name, Asset::Type::Mde, bytes);
     }
 
     std::vector<Graphics::Texture*> Cache::get_textures(std::string name) const {
         auto pair = m_textures.find(name);
 
         std::vector<Graphics::Texture*> textures;
+        if (pair == m_textures.end())
+            return textures;
 
         for (auto &texture_ptr : pair->second) {
             textures.push_back(texture_ptr.get());
@@ -46,10 +197,198 @@ namespace Assets {
     }
 
     void Cache::set_textures(std::string name, Graphics::MipTexturesList &&textures) {
-        m_textures.insert(std::make_pair(name, std::move(textures)));
+        size_t bytes = 0;
+        for (const auto &texture : textures)
+            bytes += texture_bytes(*texture);
+
+        if (m_textures.insert(std::make_pair(name, std::move(textures))).second)
+            add_entry(name, Asset::Type::Texture, bytes);
+    }
+
+    Graphics::Mesh* Cache::acquire_mesh(std::string name) {
+        auto mesh = get_mesh(name);
+
+        if (mesh != nullptr) {
+            auto &entry = m_entries[name];
+            entry.references++;
+            entry.pinned = false;
+            entry.last_use = ++m_use_clock;
+        }
+
+        return mesh;
+    }
+
+    std::vector<Graphics::Texture*> Cache::acquire_textures(std::string name) {
+        auto textures = get_textures(name);
+
+        if (!textures.empty()) {
+            auto &entry = m_entries[name];
+            entry.references++;
+            entry.pinned = false;
+            entry.last_use = ++m_use_clock;
+        }
+
+        return textures;
+    }
+
+    void Cache::release(std::string name) {
+        auto entry = m_entries.find(name);
+        if (entry == m_entries.end())
+            return;
+
+        if (entry->second.references == 0) {
+            if (!entry->second.pinned)
+                return;
+
+            entry->second.pinned = false;
+        } else {
+            entry->second.references--;
+        }
+
+        entry->second.last_use = ++m_use_clock;
+
+        enforce_budget();
+    }
+
+    void Cache::set_memory_budget(size_t budget) {
+        m_memory_budget = budget;
+
+        enforce_budget();
+    }
+
+    void Cache::add_entry(const std::string &name, Asset::Type type, size_t bytes) {
+        CacheEntry entry;
+        entry.type = type;
+        entry.bytes = bytes;
+        entry.last_use = ++m_use_clock;
+
+        m_entries[name] = entry;
+        m_memory_used += bytes;
+    }
+
+    void Cache::evict(const std::string &name) {
+        auto entry = m_entries.find(name);
+        if (entry == m_entries.end())
+            return;
+
+        if (entry->second.type == Asset::Type::Texture) {
+            m_textures.erase(name);
+            m_asset_data.erase(name);
+        } else {
+            m_meshes.erase(name);
+        }
+
+        m_memory_used -= entry->second.bytes;
+        m_entries.erase(entry);
+    }
+
+    void Cache::enforce_budget() {
+        if (m_memory_budget == 0)
+            return;
+
+        while (m_memory_used > m_memory_budget) {
+            const std::string *oldest = nullptr;
+            uint64_t oldest_use = UINT64_MAX;
+
+            for (const auto &[name, entry] : m_entries) {
+                if (entry.references == 0 && !entry.pinned && entry.last_use < oldest_use) {
+                    oldest = &name;
+                    oldest_use = entry.last_use;
+                }
+            }
+
+            // everything left is in use, the budget can't be met right now
+            if (oldest == nullptr)
+                break;
+
+            evict(*oldest);
+        }
+    }
+
+    std::vector<AssetMemory> Cache::get_memory_report() const {
+        std::vector<AssetMemory> report;
+
+        for (const auto &[name, entry] : m_entries) {
+            AssetMemory memory;
+            memory.name = name;
+            memory.type = entry.type;
+            memory.references = entry.references;
+            memory.bytes = entry.bytes;
+
+            if (entry.type == Asset::Type::Texture) {
+                for (auto texture : get_textures(name))
+                    memory.level_bytes.push_back(texture_bytes(*texture));
+            }
+
+            report.push_back(memory);
+        }
+
+        std::sort(report.begin(), report.end(), [](const AssetMemory &a, const AssetMemory &b) {
+            return a.bytes > b.bytes;
+        });
+
+        return report;
+    }
+
+    void Cache::log_memory_report() const {
+        Logger::log(LogLevel::Info, "Asset cache: " + std::to_string(m_memory_used / 1024) + " KB of "
+                + (m_memory_budget == 0 ? std::string("unlimited") : std::to_string(m_memory_budget / 1024) + " KB"), false);
+
+        for (const auto &memory : get_memory_report()) {
+            std::string line = "  " + memory.name + ": " + std::to_string(memory.bytes / 1024) + " KB, "
+                + std::to_string(memory.references) + " refs";
+
+            for (size_t level = 0; level < memory.level_bytes.size(); level++)
+                line += (level == 0 ? " [" : ", ") + std::to_string(memory.level_bytes[level]);
+
+            if (!memory.level_bytes.empty())
+                line += "]";
+
+            Logger::log(LogLevel::Info, line, false);
+        }
+    }
+
+    bool Cache::mount(const std::string &path) {
+        auto archive = std::make_shared<PakReader>();
+        if (!archive->open(path))
+            return false;
+
+        m_archives.push_back(std::move(archive));
+
+        return true;
+    }
+
+    bool Cache::open_asset(const std::string &name, AssetData &data) const {
+        for (auto archive = m_archives.rbegin(); archive != m_archives.rend(); archive++) {
+            auto entry = (*archive)->find(name);
+            if (entry == nullptr)
+                continue;
+
+            if (entry->flags & PakEntryCompressed) {
+                if (!(*archive)->read(*entry, data.buffer))
+                    return false;
+
+                data.data = data.buffer.data();
+                data.size = data.buffer.size();
+            } else {
+                // the archive stays mounted for the lifetime of the cache
+                data.data = (*archive)->entry_data(*entry);
+                data.size = entry->size;
+            }
+
+            return true;
+        }
+
+        if (!std::filesystem::exists(name) || !data.file.open(name))
+            return false;
+
+        data.data = data.file.data();
+        data.size = data.file.size();
+
+        return true;
     }
 
-    void Cache::release_textures(std::string name) {
-        m_textures.erase(name);
+    void Cache::keep_asset_data(std::string name, AssetData &&data) {
+        m_asset_data[name] = std::move(data);
     }
 }
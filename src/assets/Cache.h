@@ -3,16 +3,94 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
 
 #include "Asset.h"
 #include "../graphics/RenderObject.h"
+#include "../io/MappedFile.h"
+#include "../io/PakReader.h"
+#include "../core/JobSystem.h"
 
 #include "AssetLoaders.h"
 
 namespace Assets {
+    class Cache;
+
+    /*
+     * Bytes of an asset. Points into a mapped loose file, into a mounted archive or into buffer
+     * when the entry had to be decompressed. data stays valid as long as the object lives.
+     */
+    struct AssetData {
+        const char *data = nullptr;
+        size_t size = 0;
+
+        MappedFile file;
+        std::vector<char> buffer;
+    };
+
+    enum class LoadState {
+        Pending,
+        Loaded,
+        Failed,
+    };
+
+    // name of the asset and whether it was loaded, always called from Cache::update
+    using LoadCallback = std::function<void(const std::string&, bool)>;
+
+    struct AsyncLoad {
+        Asset::Type type;
+        std::string filename;
+        AssetOptions options;
+
+        std::vector<LoadCallback> callbacks;
+
+        // the loader runs against its own cache, update moves the results over
+        std::unique_ptr<Cache> staging;
+        bool success = false;
+
+        std::atomic<LoadState> state { LoadState::Pending };
+    };
+
+    class AssetHandle {
+        public:
+            AssetHandle() = default;
+
+            LoadState get_state() const {
+                return p_load ? p_load->state.load(std::memory_order_acquire) : LoadState::Failed;
+            }
+
+            bool is_pending() const {
+                return get_state() == LoadState::Pending;
+            }
+
+            const std::string& get_filename() const {
+                return p_load->filename;
+            }
+        private:
+            friend class Cache;
+
+            AssetHandle(std::shared_ptr<AsyncLoad> load) : p_load(std::move(load)) {}
+
+            std::shared_ptr<AsyncLoad> p_load;
+    };
+
+    struct AssetMemory {
+        std::string name;
+        Asset::Type type;
+
+        int references;
+        size_t bytes;
+
+        // bytes of every mip level, empty for meshes
+        std::vector<size_t> level_bytes;
+    };
+
     class Cache final {
         public:
-            Cache();
+            /* without a job system, or with a single thread, asynchronous loads run inline */
+            Cache(Core::JobSystem *job_system = nullptr);
             ~Cache();
 
             Cache(const Cache &cache) = delete;
@@ -24,18 +102,108 @@ namespace Assets {
             void load_asset(Asset::Type asset_type, const std::string &filename,
                     const AssetOptions &options);
 
+            /*
+             * Decodes the asset on a background job. Nothing becomes visible in the cache before
+             * update publishes it and runs the callback on the calling thread. Requests for a name
+             * that is already loading share one load.
+             */
+            AssetHandle load_asset_async(Asset::Type asset_type, const std::string &filename,
+                    const AssetOptions &options, LoadCallback callback = nullptr);
+
+            /* publishes finished asynchronous loads, call it once per frame from the main thread */
+            void update();
+
+            bool has_pending_loads() const {
+                return !m_pending.empty();
+            }
+
+            /* returns nullptr when the mesh isn't loaded */
             Graphics::Mesh* get_mesh(std::string name) const;
             void set_mesh(std::string name, std::unique_ptr<Graphics::Mesh> mesh);
-            void release_mesh(std::string name);
 
+            /* returns an empty list when the textures aren't loaded */
             std::vector<Graphics::Texture*> get_textures(std::string name) const;
             void set_textures(std::string name, Graphics::MipTexturesList &&textures);
-            void release_textures(std::string name);
+
+            /*
+             * Like get_mesh and get_textures, but the asset can't be evicted before every
+             * reference is given back with release. A release without an acquire gives back the
+             * pin of an asynchronous load that turned out not to be needed.
+             */
+            Graphics::Mesh* acquire_mesh(std::string name);
+            std::vector<Graphics::Texture*> acquire_textures(std::string name);
+            void release(std::string name);
+
+            /*
+             * Unreferenced assets are evicted, least recently used first, while the cache holds more
+             * than budget bytes. Eviction happens in set_memory_budget, release and update. An
+             * asynchronous load pins its asset when update publishes it, so it survives until it
+             * is acquired, even across the updates of a load that depends on it. 0 disables the budget.
+             */
+            void set_memory_budget(size_t budget);
+
+            size_t get_memory_usage() const {
+                return m_memory_used;
+            }
+
+            /* memory of every loaded asset, textures list each mip level */
+            std::vector<AssetMemory> get_memory_report() const;
+            void log_memory_report() const;
+
+            /*
+             * Makes the entries of the archive visible to every loader. Archives mounted later
+             * take precedence, names that no archive holds are read from loose files.
+             */
+            bool mount(const std::string &path);
+
+            /* looks the asset up in the mounted archives first, then on disk */
+            bool open_asset(const std::string &name, AssetData &data) const;
+
+            /* keeps the data that assets of the same name point into alive until they are evicted */
+            void keep_asset_data(std::string name, AssetData &&data);
 
         private:
+            Core::JobSystem *p_job_system = nullptr;
+            Core::JobCounter m_load_jobs;
+
+            std::unordered_map<std::string, std::shared_ptr<AsyncLoad>> m_pending;
+
+            std::mutex m_finished_mutex;
+            std::vector<std::shared_ptr<AsyncLoad>> m_finished;
+
             std::unordered_map<std::string, Graphics::MipTexturesList> m_textures;
             std::unordered_map<std::string, std::unique_ptr<Graphics::Mesh>> m_meshes;
+            std::unordered_map<std::string, AssetData> m_asset_data;
+
+            // shared with the staging caches of asynchronous loads
+            std::vector<std::shared_ptr<PakReader>> m_archives;
 
             std::vector<std::pair<Asset::Type, AssetLoader>> m_loaders;
+
+            struct CacheEntry {
+                Asset::Type type;
+
+                int references = 0;
+                uint64_t last_use = 0;
+
+                // published by update and not acquired yet
+                bool pinned = false;
+                size_t bytes = 0;
+            };
+
+            std::unordered_map<std::string, CacheEntry> m_entries;
+            uint64_t m_use_clock = 0;
+
+            size_t m_memory_budget = 0;
+            size_t m_memory_used = 0;
+
+            void add_entry(const std::string &name, Asset::Type type, size_t bytes);
+            void evict(const std::string &name);
+            void enforce_budget();
+
+            bool run_loader(Asset::Type asset_type, const std::string &filename, const AssetOptions &options);
+            void run_async_load(const std::shared_ptr<AsyncLoad> &load);
+
+            void merge(Cache &&other);
     };
 }
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <filesystem>
 
 #include "Application.h"
 #include "../graphics/Core.h"
@@ -7,6 +8,7 @@
 #include "../graphics/Font.h"
 #include "../graphics/RenderPipeline.h"
 #include "../graphics/ObjectRepository.h"
+#include "../graphics/DynamicResolution.h"
 
 #include "../math/Core.h"
 
@@ -44,6 +46,21 @@ bool Application::initialize(const AppSettings &settings) {
         return false;
     }
 
+    Core::JobSystemSettings job_settings;
+    job_settings.num_threads = settings.worker_threads;
+    job_settings.pin_threads = settings.pin_worker_threads;
+
+    p_job_system = std::make_unique<Core::JobSystem>(job_settings);
+
+    m_asset_memory_budget = settings.asset_memory_budget;
+    m_gamma = settings.gamma;
+    m_color_lut_path = settings.color_lut_path;
+
+    m_dynamic_resolution = settings.dynamic_resolution;
+    m_min_resolution_scale = settings.min_resolution_scale;
+    m_bilinear_upscale = settings.bilinear_upscale;
+    m_interlaced = settings.interlaced;
+
     return true;
 }
 
@@ -51,7 +68,12 @@ void Application::run() {
     m_running = true;
 
     Graphics::Renderer renderer;
-    Graphics::RenderPipeline render_pipeline {&renderer};
+    Graphics::RenderPipeline render_pipeline {&renderer, p_job_system.get()};
+
+    Graphics::ColorLut color_lut;
+    bool has_lut = !m_color_lut_path.empty() && color_lut.load_cube(m_color_lut_path);
+
+    renderer.set_color_grading(m_gamma, has_lut ? &color_lut : nullptr);
 
     auto win_width = m_window.get_width();
     auto win_height = m_window.get_height();
@@ -59,7 +81,13 @@ void Application::run() {
     m_rc.attributes = Graphics::RCAttributeMipMapped
         | Graphics::RCAttributeINVZBuffer
         | Graphics::RCAttributeTextureHybrid
-        | Graphics::RCAttributeZSort;
+        | Graphics::RCAttributeZSort
+        | Graphics::RCAttributeParallel
+        | Graphics::RCAttributeVertexLighting
+        | Graphics::RCAttributeLevelOfDetail;
+
+    if (m_interlaced)
+        m_rc.attributes |= Graphics::RCAttributeInterlaced;
 
     m_rc.mip_z_dist = 80;
     m_rc.perfect_dist = 20;
@@ -88,20 +116,41 @@ void Application::run() {
     m_cursor.initialize(&m_window);
 
     std::vector<Graphics::RenderObject> objects;
-    Graphics::ObjectRepository object_repository;
+    Graphics::ObjectRepository object_repository {p_job_system.get()};
+    object_repository.get_cache().set_memory_budget(m_asset_memory_budget);
 
-    // auto object = object_repository.create_render_object("assets/test.mde");
-    auto plateau = object_repository.create_render_object("assets/valley.mde");
+    // built by tools/asset_packer, anything the archive doesn't hold is still read from assets/
+    if (std::filesystem::exists("assets.pak"))
+        object_repository.get_cache().mount("assets.pak");
 
+    // auto object = object_repository.create_render_object("assets/test.mde");
     // object.transform = Graphics::Transform(V4D(10, 0, 10));
-    plateau.transform = Graphics::Transform(V4D(0, -5, 0));
-
     // objects.push_back(object);
-    objects.push_back(plateau);
+
+    // the plateau shows up once it is loaded, the frame loop keeps running meanwhile
+    object_repository.create_render_object_async("assets/valley.mde", [&objects](Graphics::RenderObject &&plateau) {
+        plateau.transform = Graphics::Transform(V4D(0, -5, 0));
+
+        // the plateau never moves, so the sun and ambient light only have to be evaluated once
+        Graphics::bake_static_lighting(plateau, Graphics::g_lights.data(), Graphics::num_lights);
+
+        objects.push_back(std::move(plateau));
+    });
 
     Graphics::TTFFont ttf_font("assets/alagard.ttf", 24);
     int dt = 0;
 
+    // the frame time only gets rasterized again when the number changes
+    Graphics::HudLayer hud;
+    int time_widget = hud.add_text(ttf_font, {20, 52});
+
+    Graphics::DynamicResolutionSettings resolution_settings;
+    resolution_settings.frame_budget_ms = 1000.0f / m_fps;
+    resolution_settings.min_scale = m_min_resolution_scale;
+
+    Graphics::DynamicResolution resolution_controller {resolution_settings};
+    auto upscale_filter = m_bilinear_upscale ? Graphics::UpscaleFilter::Bilinear : Graphics::UpscaleFilter::Nearest;
+
     while (m_running) {
         m_cursor.reset_pos_middle();
 
@@ -109,15 +158,39 @@ void Application::run() {
 
         poll_window_events();
 
+        if (m_dynamic_resolution) {
+            int render_width, render_height;
+            resolution_controller.get_resolution(m_window.get_width(), m_window.get_height(), render_width, render_height);
+
+            // a resize puts everything back to the window size, so this also runs after one
+            if (render_width != m_rc.max_clip_x || render_height != m_rc.max_clip_y) {
+                m_rc.max_clip_x = render_width;
+                m_rc.max_clip_y = render_height;
+
+                p_camera->set_viewport(render_width, render_height);
+                renderer.set_render_resolution(render_width, render_height, upscale_filter);
+
+                // the rows of the other field are still packed at the old width
+                m_rc.interlace_history = false;
+            }
+        }
+
+        object_repository.update();
+
+        // the fields take turns, so every row is drawn every second frame
+        m_rc.interlace_field ^= 1;
+
         render_pipeline.render_objects(*p_camera, objects, m_rc);
 
-        string time_text = std::to_string(dt) + "MS";
-        renderer.render_text(time_text, ttf_font, {20, 52});
+        hud.set_text(time_widget, std::to_string(dt) + "MS");
 
-        renderer.render_framebuffer();
+        renderer.render_framebuffer(&hud, &m_rc);
         // objects[0].transform.rotate(Quat_Type(V4D(0, 1, 0), Math::deg_to_rad(1)));
 
         dt = static_cast<int>(get_program_ticks_ms() - cycle_start);
+
+        if (m_dynamic_resolution)
+            resolution_controller.update(dt);
         int cycle_delay = (1000.0f / (float)m_fps) - dt;
 
         if (cycle_delay > 0) {
@@ -126,6 +199,8 @@ void Application::run() {
 
         emit_mouse_motion_event();
     }
+
+    object_repository.get_cache().log_memory_report();
 }
 
 void Application::emit_mouse_motion_event() {
@@ -159,6 +234,9 @@ void Application::poll_window_events() {
                 }
 
                 p_camera->set_viewport(event.body.expose_event.width, event.body.expose_event.height);
+
+                // the renderer starts over with an empty framebuffer
+                m_rc.interlace_history = false;
                 emit_event(event, event.event_type);
             }
             break;
@@ -184,6 +262,10 @@ Core::Cursor* Application::get_cursor() {
     return &m_cursor;
 }
 
+Core::JobSystem* Application::get_job_system() {
+    return p_job_system.get();
+}
+
 void Application::send_window_event(WindowEvent event) {
     emit_event(event, WindowEventType::WinExpose);
 }
@@ -5,12 +5,33 @@
 #include "../graphics/Camera.h"
 #include "../graphics/RenderObject.h"
 #include <memory>
+#include <string>
 
 #include "Cursor.h"
+#include "JobSystem.h"
 
 struct AppSettings {
     int win_width;
     int win_height;
+
+    // 0 = one worker thread per core
+    int worker_threads = 0;
+    bool pin_worker_threads = false;
+
+    // bytes the asset cache may hold before unused assets are evicted, 0 = no limit
+    size_t asset_memory_budget = 0;
+
+    // applied when the frame is presented, 1 and no lut leave the colours as they are
+    float gamma = 1.0f;
+    std::string color_lut_path = "";
+
+    // render the scene at a lower resolution when frames take longer than 1000 / fps
+    bool dynamic_resolution = false;
+    float min_resolution_scale = 0.5f;
+    bool bilinear_upscale = true;
+
+    // draw every other row each frame and rebuild the rest from the frame before
+    bool interlaced = false;
 };
 
 class Application : public MultiEventSubject<WindowEvent> {
@@ -25,6 +46,7 @@ public:
     static std::shared_ptr<Application> get_instance();
     GWindow* get_window();
     Core::Cursor* get_cursor();
+    Core::JobSystem* get_job_system();
 
     bool initialize(const AppSettings &settings);
     void run();
@@ -35,9 +57,18 @@ protected:
 private:
     GWindow m_window;
     Core::Cursor m_cursor;
+    std::unique_ptr<Core::JobSystem> p_job_system { nullptr };
     std::unique_ptr<Graphics::Camera> p_camera { nullptr };
     bool m_running;
     int m_fps;
+    size_t m_asset_memory_budget = 0;
+    float m_gamma = 1.0f;
+    std::string m_color_lut_path;
+
+    bool m_dynamic_resolution = false;
+    float m_min_resolution_scale = 0.5f;
+    bool m_bilinear_upscale = true;
+    bool m_interlaced = false;
 
     Graphics::RenderContext m_rc;
 
@@ -0,0 +1,325 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+namespace Core {
+
+static constexpr int QueueCapacity = 4096;
+
+// amount of failed attempts to find work before a worker goes to sleep
+static constexpr int IdleSpins = 64;
+
+static thread_local const JobSystem *t_job_system = nullptr;
+static thread_local int t_worker_index = -1;
+
+WorkStealingQueue::WorkStealingQueue(int capacity) {
+    m_mask = capacity - 1;
+    p_buffer = std::make_unique<std::atomic<Job*>[]>(capacity);
+}
+
+bool WorkStealingQueue::push(Job *job) {
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top = m_top.load(std::memory_order_acquire);
+
+    if (bottom - top > m_mask)
+        return false;
+
+    p_buffer[bottom & m_mask].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+Job* WorkStealingQueue::pop() {
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job *job = p_buffer[bottom & m_mask].load(std::memory_order_relaxed);
+
+    if (top == bottom) {
+        // last job in the queue, race against the thieves for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Job* WorkStealingQueue::steal() {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+        return nullptr;
+
+    Job *job = p_buffer[top & m_mask].load(std::memory_order_relaxed);
+
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+
+    return job;
+}
+
+static void pin_thread(int core) {
+    int num_cores = std::max(1u, std::thread::hardware_concurrency());
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core % num_cores, &cpu_set);
+
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+}
+
+JobSystem::JobSystem(const JobSystemSettings &settings) {
+    int num_threads = settings.num_threads;
+    if (num_threads <= 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 0; i < num_threads; i++)
+        m_queues.push_back(std::make_unique<WorkStealingQueue>(QueueCapacity));
+
+    // the creating thread is worker 0
+    t_job_system = this;
+    t_worker_index = 0;
+
+    if (settings.pin_threads)
+        pin_thread(settings.first_core);
+
+    for (int i = 1; i < num_threads; i++)
+        m_threads.emplace_back(&JobSystem::worker_loop, this, i, settings);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stopping = true;
+    }
+
+    m_sleep_cv.notify_all();
+
+    for (auto &thread : m_threads)
+        thread.join();
+
+    // drop the jobs that never ran
+    for (auto &queue : m_queues) {
+        while (auto job = queue->pop())
+            delete job;
+    }
+
+    for (auto job : m_injected)
+        delete job;
+
+    for (auto job : m_background)
+        delete job;
+
+    if (t_job_system == this) {
+        t_job_system = nullptr;
+        t_worker_index = -1;
+    }
+}
+
+int JobSystem::get_worker_index() const {
+    return t_job_system == this ? t_worker_index : -1;
+}
+
+void JobSystem::submit(std::function<void()> fn, JobCounter *counter, const JobCounter *dependency) {
+    if (counter != nullptr)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    enqueue(new Job { std::move(fn), counter, dependency });
+}
+
+void JobSystem::submit_background(std::function<void()> fn, JobCounter *counter) {
+    if (counter != nullptr)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        m_background.push_back(new Job { std::move(fn), counter, nullptr });
+    }
+
+    m_queued_jobs.fetch_add(1, std::memory_order_seq_cst);
+
+    if (m_sleeping_workers.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_sleep_cv.notify_one();
+    }
+}
+
+void JobSystem::enqueue(Job *job) {
+    int worker_index = get_worker_index();
+
+    if (worker_index < 0 || !m_queues[worker_index]->push(job)) {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        m_injected.push_back(job);
+    }
+
+    m_queued_jobs.fetch_add(1, std::memory_order_seq_cst);
+
+    // only pay for the lock when somebody is actually asleep
+    if (m_sleeping_workers.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_sleep_cv.notify_one();
+    }
+}
+
+Job* JobSystem::find_job(int worker_index) {
+    if (worker_index >= 0) {
+        if (auto job = m_queues[worker_index]->pop())
+            return job;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        if (!m_injected.empty()) {
+            auto job = m_injected.front();
+            m_injected.pop_front();
+
+            return job;
+        }
+    }
+
+    int num_queues = m_queues.size();
+    int start = worker_index < 0 ? 0 : worker_index + 1;
+
+    for (int i = 0; i < num_queues; i++) {
+        int victim = (start + i) % num_queues;
+        if (victim == worker_index)
+            continue;
+
+        if (auto job = m_queues[victim]->steal())
+            return job;
+    }
+
+    // frame work always comes first, background jobs only fill idle workers
+    if (worker_index != 0) {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        if (!m_background.empty()) {
+            auto job = m_background.front();
+            m_background.pop_front();
+
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+bool JobSystem::run_one(int worker_index) {
+    auto job = find_job(worker_index);
+    if (job == nullptr)
+        return false;
+
+    m_queued_jobs.fetch_sub(1, std::memory_order_acq_rel);
+
+    if (job->dependency != nullptr && !job->dependency->done()) {
+        // not ready yet, hand it back so another job gets a chance first
+        {
+            std::lock_guard<std::mutex> lock(m_injection_mutex);
+            m_injected.push_back(job);
+        }
+
+        m_queued_jobs.fetch_add(1, std::memory_order_release);
+        std::this_thread::yield();
+
+        return false;
+    }
+
+    execute(job, worker_index);
+
+    return true;
+}
+
+void JobSystem::execute(Job *job, int worker_index) {
+    job->fn();
+
+    if (job->counter != nullptr)
+        job->counter->value.fetch_sub(1, std::memory_order_acq_rel);
+
+    delete job;
+}
+
+void JobSystem::wait(const JobCounter &counter) {
+    int worker_index = get_worker_index();
+
+    while (!counter.done()) {
+        if (!run_one(worker_index))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallel_for(int count, int chunk_size, const RangeFn &fn) {
+    if (count <= 0)
+        return;
+
+    if (chunk_size <= 0)
+        chunk_size = 1;
+
+    if (count <= chunk_size || m_queues.size() == 1) {
+        int worker_index = std::max(0, get_worker_index());
+
+        for (int begin = 0; begin < count; begin += chunk_size)
+            fn(begin, std::min(begin + chunk_size, count), worker_index);
+
+        return;
+    }
+
+    JobCounter counter;
+
+    for (int begin = 0; begin < count; begin += chunk_size) {
+        int end = std::min(begin + chunk_size, count);
+
+        submit([this, &fn, begin, end] {
+            fn(begin, end, get_worker_index());
+        }, &counter);
+    }
+
+    wait(counter);
+}
+
+void JobSystem::worker_loop(int worker_index, const JobSystemSettings &settings) {
+    t_job_system = this;
+    t_worker_index = worker_index;
+
+    if (settings.pin_threads)
+        pin_thread(settings.first_core + worker_index);
+
+    int idle_spins = 0;
+
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        if (run_one(worker_index)) {
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < IdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleeping_workers.fetch_add(1, std::memory_order_seq_cst);
+
+        m_sleep_cv.wait(lock, [this] {
+            return m_stopping.load(std::memory_order_acquire) || m_queued_jobs.load(std::memory_order_seq_cst) > 0;
+        });
+
+        m_sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+        idle_spins = 0;
+    }
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <memory>
+
+namespace Core {
+
+/*
+ * Counts outstanding jobs. A counter is incremented for every job that is submitted with it
+ * and decremented when that job finishes, so a counter of zero means all its jobs are done.
+ * Counters are also used as dependencies: a job that depends on a counter won't start before
+ * the counter reached zero.
+ */
+struct JobCounter {
+    std::atomic<int> value {0};
+
+    bool done() const {
+        return value.load(std::memory_order_acquire) == 0;
+    }
+};
+
+struct Job {
+    std::function<void()> fn;
+
+    JobCounter *counter = nullptr;
+    const JobCounter *dependency = nullptr;
+};
+
+/*
+ * Chase-Lev work stealing deque. Only the owning thread pushes and pops at the bottom,
+ * other threads steal from the top.
+ */
+class WorkStealingQueue {
+public:
+    WorkStealingQueue(int capacity);
+
+    WorkStealingQueue(const WorkStealingQueue &other) = delete;
+    WorkStealingQueue& operator=(const WorkStealingQueue &other) = delete;
+
+    /* returns false when the queue is full */
+    bool push(Job *job);
+    Job* pop();
+    Job* steal();
+private:
+    std::atomic<int64_t> m_top {0};
+    std::atomic<int64_t> m_bottom {0};
+
+    int64_t m_mask;
+    std::unique_ptr<std::atomic<Job*>[]> p_buffer;
+};
+
+struct JobSystemSettings {
+    // amount of threads including the thread that creates the job system, 0 = one per core
+    int num_threads = 0;
+
+    // pins every worker to its own core, starting at first_core
+    bool pin_threads = false;
+    int first_core = 0;
+};
+
+/*
+ * Engine wide job scheduler. Every worker owns a work stealing deque, idle workers steal
+ * from the others. The thread that creates the job system is registered as worker 0 and
+ * executes jobs while it waits on a counter. Jobs submitted from threads that aren't
+ * workers go through a shared injection queue.
+ */
+class JobSystem {
+public:
+    // fn(begin, end, worker_index)
+    using RangeFn = std::function<void(int, int, int)>;
+
+    JobSystem(const JobSystemSettings &settings);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &other) = delete;
+    JobSystem(JobSystem &&other) = delete;
+
+    JobSystem& operator=(const JobSystem &other) = delete;
+    JobSystem& operator=(JobSystem &&other) = delete;
+
+    int get_num_threads() const {
+        return m_queues.size();
+    }
+
+    /* index of the calling worker, -1 when called from a thread that isn't a worker */
+    int get_worker_index() const;
+
+    void submit(std::function<void()> fn, JobCounter *counter = nullptr,
+            const JobCounter *dependency = nullptr);
+
+    /*
+     * For long running work like loading assets. Background jobs are never executed by worker 0,
+     * so the thread that drives the frame doesn't get stuck in one while it waits on a counter.
+     * With a single thread they never run.
+     */
+    void submit_background(std::function<void()> fn, JobCounter *counter = nullptr);
+
+    /* executes other jobs on the calling thread until the counter reaches zero */
+    void wait(const JobCounter &counter);
+
+    /*
+     * Runs fn over [0, count) in chunks of chunk_size and blocks until every chunk is done.
+     * Ranges smaller than one chunk run inline on the calling thread.
+     */
+    void parallel_for(int count, int chunk_size, const RangeFn &fn);
+private:
+    std::vector<std::unique_ptr<WorkStealingQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_injection_mutex;
+    std::deque<Job*> m_injected;
+    std::deque<Job*> m_background;
+
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_cv;
+    std::atomic<int> m_queued_jobs {0};
+    std::atomic<int> m_sleeping_workers {0};
+    std::atomic<bool> m_stopping {false};
+
+    void worker_loop(int worker_index, const JobSystemSettings &settings);
+    void enqueue(Job *job);
+    Job* find_job(int worker_index);
+    bool run_one(int worker_index);
+    void execute(Job *job, int worker_index);
+};
+
+}
@@ -0,0 +1,178 @@
+#include "Blitter.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Graphics {
+
+// x / 255 rounded, exact for every product of two bytes
+static constexpr uint32_t div_255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+BlitSurface BlitSurface::from_texture(const Texture &texture, bool has_alpha) {
+    BlitSurface surface;
+    surface.width = texture.width;
+    surface.height = texture.height;
+    surface.pixels.resize(texture.width * texture.height);
+
+    auto pixels = texture.get_pixels();
+
+    for (int i = 0; i < texture.width * texture.height; i++) {
+        uint32_t value = pixels[i];
+
+        // expanded the same way A565Color::rgba_bit does it
+        uint32_t a = has_alpha ? (value >> 24) & 0xFF : 0xFF;
+        uint32_t r = ((value >> 11) & 31) << 3;
+        uint32_t g = ((value >> 5) & 63) << 2;
+        uint32_t b = (value & 31) << 3;
+
+        surface.pixels[i] = (a << 24) | (div_255(r * a) << 16) | (div_255(g * a) << 8) | div_255(b * a);
+    }
+
+    return surface;
+}
+
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t src) {
+    uint32_t inv_alpha = 255 - (src >> 24);
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t channel = ((src >> shift) & 0xFF) + div_255(((dst >> shift) & 0xFF) * inv_alpha);
+        result |= std::min(channel, 255u) << shift;
+    }
+
+    return result;
+}
+
+static inline uint32_t add_pixel(uint32_t dst, uint32_t src) {
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t channel = ((src >> shift) & 0xFF) + ((dst >> shift) & 0xFF);
+        result |= std::min(channel, 255u) << shift;
+    }
+
+    return result;
+}
+
+#if defined(__SSE2__)
+// dst * (255 - src alpha) / 255 for two pixels widened to 16 bit lanes
+static inline __m128i scale_by_inv_alpha(__m128i dst16, __m128i src16) {
+    const __m128i v_255 = _mm_set1_epi16(255);
+    const __m128i v_128 = _mm_set1_epi16(128);
+
+    // the alpha word of each pixel copied to all four of its lanes
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i product = _mm_add_epi16(_mm_mullo_epi16(dst16, _mm_sub_epi16(v_255, alpha)), v_128);
+
+    return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+}
+#endif
+
+void blend_row(uint32_t *dst, const uint32_t *src, int count, BlendMode mode) {
+    int i = 0;
+
+    if (mode == BlendMode::Opaque) {
+        std::copy(src, src + count, dst);
+        return;
+    }
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+        // premultiplied, so four transparent pixels leave the target as it is
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF)
+            continue;
+
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+
+        if (mode == BlendMode::Alpha) {
+            __m128i lo = scale_by_inv_alpha(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+            __m128i hi = scale_by_inv_alpha(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+
+            d = _mm_packus_epi16(lo, hi);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epu8(s, d));
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (src[i] == 0)
+            continue;
+
+        dst[i] = mode == BlendMode::Alpha ? blend_pixel(dst[i], src[i]) : add_pixel(dst[i], src[i]);
+    }
+}
+
+void blit(const BlitTarget &target, const BlitSurface &surface, const Rect &src, const Rect &dest, BlendMode mode) {
+    if (dest.width <= 0 || dest.height <= 0 || src.width <= 0 || src.height <= 0)
+        return;
+
+    int x_begin = std::max(0, dest.x_pos);
+    int y_begin = std::max(0, dest.y_pos);
+    int x_end = std::min(target.width, dest.x_pos + dest.width);
+    int y_end = std::min(target.height, dest.y_pos + dest.height);
+
+    if (x_begin >= x_end || y_begin >= y_end)
+        return;
+
+    int x_step = (src.width << 16) / dest.width;
+    int y_step = (src.height << 16) / dest.height;
+
+    int count = x_end - x_begin;
+    int u_begin = (x_begin - dest.x_pos) * x_step;
+    int v = (y_begin - dest.y_pos) * y_step;
+
+    static thread_local std::vector<uint32_t> scaled_row;
+
+    bool unscaled = x_step == 1 << 16;
+    if (!unscaled && (int)scaled_row.size() < count)
+        scaled_row.resize(count);
+
+    auto dst_pixels = reinterpret_cast<uint32_t*>(target.pixels);
+
+    for (int y = y_begin; y < y_end; y++, v += y_step) {
+        auto src_row = surface.pixels.data() + surface.width * (src.y_pos + (v >> 16)) + src.x_pos;
+        const uint32_t *row = src_row + (u_begin >> 16);
+
+        if (!unscaled) {
+            int u = u_begin;
+
+            for (int x = 0; x < count; x++, u += x_step)
+                scaled_row[x] = src_row[u >> 16];
+
+            row = scaled_row.data();
+        }
+
+        blend_row(dst_pixels + target.width * y + x_begin, row, count, mode);
+    }
+}
+
+void SpriteBatch::submit(const BlitSurface &surface, const Rect &src, const Rect &dest, BlendMode mode) {
+    m_sprites.push_back(Sprite { &surface, src, dest, mode });
+}
+
+void SpriteBatch::submit(const BlitSurface &surface, int x_pos, int y_pos, BlendMode mode) {
+    Rect src { surface.width, surface.height, 0, 0 };
+    Rect dest { surface.width, surface.height, x_pos, y_pos };
+
+    submit(surface, src, dest, mode);
+}
+
+void SpriteBatch::flush(const BlitTarget &target) {
+    for (const auto &sprite : m_sprites)
+        blit(target, *sprite.surface, sprite.src, sprite.dest, sprite.mode);
+
+    m_sprites.clear();
+}
+
+}
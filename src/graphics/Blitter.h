@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Texture.h"
+#include "RenderObject.h"
+
+namespace Graphics {
+
+/*
+ * Image in the pixel format of the framebuffer with the colors already multiplied by alpha,
+ * so blending needs a single multiply per channel and fully transparent pixels are zero.
+ */
+struct BlitSurface {
+    int width = 0;
+    int height = 0;
+
+    std::vector<uint32_t> pixels;
+
+    /* textures decoded from a bmp carry no alpha, those are converted with has_alpha = false */
+    static BlitSurface from_texture(const Texture &texture, bool has_alpha = true);
+};
+
+struct BlitTarget {
+    Pixel *pixels;
+    int width;
+    int height;
+};
+
+enum class BlendMode {
+    Opaque,     // src
+    Alpha,      // src + dst * (1 - src alpha)
+    Additive,   // src + dst, saturated
+};
+
+/*
+ * Draws the src rect of the surface scaled to the dest rect with nearest sampling. The
+ * stepping is done in 16.16 fixed point and dest is clipped against the target.
+ */
+void blit(const BlitTarget &target, const BlitSurface &surface, const Rect &src, const Rect &dest,
+        BlendMode mode = BlendMode::Alpha);
+
+/* blends count premultiplied pixels of src onto dst, 4 at a time with SSE2 */
+void blend_row(uint32_t *dst, const uint32_t *src, int count, BlendMode mode);
+
+struct Sprite {
+    const BlitSurface *surface;
+    Rect src;
+    Rect dest;
+    BlendMode mode;
+};
+
+/*
+ * Collects the sprites of a frame, so HUD, UI and particles are drawn in one pass after the
+ * scene. Sprites are drawn in the order they were submitted.
+ */
+class SpriteBatch {
+public:
+    /* the surface has to stay alive until the batch is flushed */
+    void submit(const BlitSurface &surface, const Rect &src, const Rect &dest, BlendMode mode = BlendMode::Alpha);
+    void submit(const BlitSurface &surface, int x_pos, int y_pos, BlendMode mode = BlendMode::Alpha);
+
+    /* draws every sprite and empties the batch */
+    void flush(const BlitTarget &target);
+
+    size_t size() const {
+        return m_sprites.size();
+    }
+private:
+    std::vector<Sprite> m_sprites;
+};
+
+}
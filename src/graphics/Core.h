@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <memory>
 #include <stdexcept>
+#include <atomic>
 
 #include "../math/Matrix.h"
 #include "../math/Vector.h"
@@ -168,27 +169,44 @@ struct V2I {
 };
 
 
+/* engine wide, so two different transforms never share a version */
+inline uint64_t next_transform_version() {
+    static std::atomic<uint64_t> counter {0};
+
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 struct Transform {
     V4D pos;
     Quat_Type rot;
     V4D scale;
 
+    // changes whenever the transform changes, code that writes pos, rot or scale directly has to call touch()
+    uint64_t version;
+
     Transform() {
         this->pos = V4D(0, 0, 0, 0);
         this->rot = Quat_Type(0, 0, 0, 1);
         this->scale = V4D(1, 1, 1, 1);
+        touch();
     }
 
     Transform(const V4D &pos) {
         this->pos = pos;
         this->rot = Quat_Type(0, 0, 0, 1);
         this->scale = V4D(1, 1, 1, 1);
+        touch();
     }
 
     Transform(const V4D &pos, const Quat_Type &rot, const V4D &scale) {
         this->pos = pos;
         this->rot = rot;
         this->scale = scale;
+        touch();
+    }
+
+    void touch() {
+        version = next_transform_version();
     }
 
     void move(const V4D &dir, float amt) {
@@ -211,10 +229,17 @@ struct Transform {
 
     void set_pos(const V4D &pos) {
         this->pos = pos;
+        touch();
+    }
+
+    void set_scale(const V4D &scale) {
+        this->scale = scale;
+        touch();
     }
 
     Transform& rotate(const Quat_Type &rotation) {
         this->rot = (rotation * rot).normalized();
+        touch();
 
         return *this;
     }
@@ -222,6 +247,7 @@ struct Transform {
     Transform& look_at(const V4D &point, const V4D &up) {
         auto mat_look_at = Math::mat_4x4_rotation(point, up);
         this->rot = Quat_Type(mat_look_at);
+        touch();
 
         return *this;
     }
@@ -0,0 +1,60 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+// weight of the newest frame in the average
+static constexpr float FrameTimeSmoothing = 0.2f;
+
+// frames the average gets to settle after a change
+static constexpr int ScaleCooldownFrames = 15;
+
+// the resolution only goes up again below this part of the budget
+static constexpr float ScaleUpHeadroom = 0.8f;
+
+DynamicResolution::DynamicResolution(const DynamicResolutionSettings &settings)
+    : m_settings(settings), m_scale(settings.max_scale) {
+
+}
+
+bool DynamicResolution::update(float frame_ms) {
+    if (m_average_ms == 0)
+        m_average_ms = frame_ms;
+    else
+        m_average_ms += (frame_ms - m_average_ms) * FrameTimeSmoothing;
+
+    if (m_cooldown > 0) {
+        m_cooldown--;
+        return false;
+    }
+
+    float budget = m_settings.frame_budget_ms;
+
+    if (m_average_ms <= budget && m_average_ms >= budget * ScaleUpHeadroom)
+        return false;
+
+    // the cost of a frame grows with the amount of pixels, so with the square of the scale
+    float wanted = m_scale * std::sqrt(budget * ScaleUpHeadroom / std::max(m_average_ms, 0.1f));
+    float step = m_settings.scale_step;
+
+    // down in one go to where the budget should fit, up one step at a time
+    float new_scale = m_average_ms > budget ? std::min(std::floor(wanted / step) * step, m_scale - step) : m_scale + step;
+    new_scale = std::clamp(new_scale, m_settings.min_scale, m_settings.max_scale);
+
+    if (std::abs(new_scale - m_scale) < step * 0.5f)
+        return false;
+
+    m_scale = new_scale;
+    m_cooldown = ScaleCooldownFrames;
+
+    return true;
+}
+
+void DynamicResolution::get_resolution(int window_width, int window_height, int &width, int &height) const {
+    width = std::clamp((int)(window_width * m_scale) & ~1, std::min(16, window_width), window_width);
+    height = std::clamp((int)(window_height * m_scale) & ~1, std::min(16, window_height), window_height);
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+namespace Graphics {
+
+struct DynamicResolutionSettings {
+    // time a frame may take before the resolution goes down
+    float frame_budget_ms = 16.0f;
+
+    float min_scale = 0.5f;
+    float max_scale = 1.0f;
+
+    // the scale only moves in steps of this size, so the buffers don't change every frame
+    float scale_step = 0.05f;
+};
+
+/*
+ * Picks the resolution the scene is rendered at from the time the last frames took. The
+ * resolution drops as soon as the average goes over the budget and only rises again when
+ * there is clear headroom, so it doesn't flip between two sizes.
+ */
+class DynamicResolution {
+public:
+    explicit DynamicResolution(const DynamicResolutionSettings &settings);
+
+    /* returns true when the scale changed */
+    bool update(float frame_ms);
+
+    float get_scale() const {
+        return m_scale;
+    }
+
+    /* the resolution for a window, always even and at least 16 pixels */
+    void get_resolution(int window_width, int window_height, int &width, int &height) const;
+private:
+    DynamicResolutionSettings m_settings;
+
+    float m_scale;
+    float m_average_ms = 0;
+    int m_cooldown = 0;
+};
+
+}
@@ -1,5 +1,6 @@
 #include "../io/BmpReader.h"
 #include "Font.h"
+#include <algorithm>
 #include <iostream>
 
 namespace Graphics {
@@ -23,10 +24,13 @@ TTFFont::TTFFont(std::string path, int size) : m_font_size(size) {
     FT_New_Face(library, path.c_str(), 0, &m_face);
     FT_Set_Pixel_Sizes(m_face, size, size);
 
-    for (char c = 0; c < 127; c++) {
+    // every glyph is rendered before the atlas is packed, its height depends on all of them
+    std::vector<A565Color> bitmaps[GlyphCount];
+
+    for (char c = 0; c < GlyphCount; c++) {
         Glyph glyph;
 
-        glyph.texture = from_char(c);
+        bitmaps[c] = from_char(c);
         glyph.width = m_face->glyph->bitmap.width;
         glyph.height = m_face->glyph->bitmap.rows;
         glyph.bearing = V2I(m_face->glyph->bitmap_left, m_face->glyph->bitmap_top);
@@ -34,6 +38,8 @@ TTFFont::TTFFont(std::string path, int size) : m_font_size(size) {
 
         m_glyphs[c] = glyph;
     }
+
+    build_atlas(bitmaps);
 }
 
 
@@ -41,33 +47,115 @@ TTFFont::~TTFFont() {
     FT_Done_Face(m_face);
 }
 
-Texture TTFFont::from_char(char c) {
+std::vector<A565Color> TTFFont::from_char(char c) {
     FT_Set_Pixel_Sizes(m_face, 0, 32);
     FT_Load_Char(m_face, c, FT_LOAD_RENDER);
 
-    auto width = m_face->glyph->bitmap.width;
-    auto height = m_face->glyph->bitmap.rows * 4;
+    auto &bitmap = m_face->glyph->bitmap;
+    int width = bitmap.width;
+    int rows = bitmap.rows;
+
+    std::vector<A565Color> buffer(width * rows);
+
+    // convert form RR format to 5 6 5 with alpha, rows can be padded in the freetype bitmap
+    for (int y = 0; y < rows; y++) {
+        auto row = reinterpret_cast<unsigned char*>(bitmap.buffer) + bitmap.pitch * y;
+
+        for (int x = 0; x < width; x++) {
+            auto val = row[x];
+            buffer[width * y + x] = A565Color(val, val, val, val);
+        }
+    }
+
+    return buffer;
+}
+
+void TTFFont::build_atlas(const std::vector<A565Color> *bitmaps) {
+    // glyphs are put next to each other on shelves as high as the highest glyph on them
+    int x_pos = 0;
+    int shelf_y = 0;
+    int shelf_height = 0;
+
+    for (int c = 0; c < GlyphCount; c++) {
+        auto &glyph = m_glyphs[c];
 
-    int size = width * height;
-    auto buffer = new A565Color[size];
+        if (x_pos + glyph.width > GlyphAtlasWidth) {
+            shelf_y += shelf_height;
+            x_pos = 0;
+            shelf_height = 0;
+        }
 
-    // convert form RR format to 5 6 5 with alpha
-    for (int i = 0; i < size; i++) {
-        auto val = reinterpret_cast<unsigned char*>(m_face->glyph->bitmap.buffer)[i];
-        buffer[i] = A565Color(val, val, val, val);
+        glyph.atlas_rect = Rect { glyph.width, glyph.height, x_pos, shelf_y };
+
+        x_pos += glyph.width;
+        shelf_height = std::max(shelf_height, glyph.height);
     }
 
-    auto texture = Texture(width, height, buffer);
-    delete[] buffer;
+    int atlas_height = std::max(1, shelf_y + shelf_height);
+    auto data = new A565Color[GlyphAtlasWidth * atlas_height]();
+
+    for (int c = 0; c < GlyphCount; c++) {
+        auto &rect = m_glyphs[c].atlas_rect;
 
-    return texture;
+        for (int y = 0; y < rect.height; y++)
+            std::copy_n(bitmaps[c].data() + rect.width * y, rect.width,
+                    data + GlyphAtlasWidth * (rect.y_pos + y) + rect.x_pos);
+    }
+
+    m_atlas = Texture(GlyphAtlasWidth, atlas_height, data);
+    delete[] data;
 }
 
-Glyph TTFFont::get_glyph(char c) const {
+const Glyph& TTFFont::get_glyph(char c) const {
     return m_glyphs[c];
 }
 
+const Texture& TTFFont::get_atlas() const {
+    return m_atlas;
+}
+
 int TTFFont::get_font_size() const {
     return m_font_size;
 }
+
+const TextRun& TTFFont::layout_text(const std::string &text) const {
+    auto cached = m_runs.find(text);
+
+    if (cached != m_runs.end()) {
+        cached->second.last_use = ++m_use_clock;
+        return cached->second.run;
+    }
+
+    if (m_runs.size() >= TextRunCacheSize) {
+        auto oldest = m_runs.begin();
+
+        for (auto it = m_runs.begin(); it != m_runs.end(); ++it) {
+            if (it->second.last_use < oldest->second.last_use)
+                oldest = it;
+        }
+
+        m_runs.erase(oldest);
+    }
+
+    CachedRun cached_run;
+    cached_run.last_use = ++m_use_clock;
+
+    auto &run = cached_run.run;
+    run.quads.reserve(text.size());
+
+    for (auto c : text) {
+        if (c < 0 || c >= GlyphCount)
+            continue;
+
+        auto &glyph = m_glyphs[c];
+
+        // fonts are rendered from top to bottom, so we need to offset smaller glyphs
+        if (glyph.width > 0 && glyph.height > 0)
+            run.quads.push_back(TextRun::Quad { glyph.atlas_rect, run.width, m_font_size - glyph.height });
+
+        run.width += glyph.advance;
+    }
+
+    return m_runs.emplace(text, std::move(cached_run)).first->second.run;
+}
 }
@@ -3,6 +3,8 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "Texture.h"
 #include "Core.h"
@@ -15,25 +17,59 @@ namespace Graphics {
 bool ttf_init();
 void ttf_quit();
 
+static constexpr int GlyphCount = 127;
+
+// width of the glyph atlas, the height follows from the glyphs
+static constexpr int GlyphAtlasWidth = 256;
+
+// laid out strings kept per font, the least recently used one goes first
+static constexpr int TextRunCacheSize = 64;
+
 struct Glyph {
     int width;
     int height;
     V2I bearing;
-    Texture texture;
+    Rect atlas_rect; // where the glyph lives in the atlas of its font
     int advance; // 1 = 1/64 of a pixel. See freetype documentation
 };
 
+/* a string with every glyph already placed, offsets are relative to the start of the text */
+struct TextRun {
+    struct Quad {
+        Rect src;
+        int x_offset;
+        int y_offset;
+    };
+
+    std::vector<Quad> quads;
+    int width = 0;
+};
+
 class TTFFont {
 public:
     TTFFont(std::string path, int size);
     ~TTFFont();
-    Glyph get_glyph(char c) const;
+    const Glyph& get_glyph(char c) const;
+    const Texture& get_atlas() const;
     int get_font_size() const;
+
+    /* the run stays valid until TextRunCacheSize other strings have been laid out */
+    const TextRun& layout_text(const std::string &text) const;
 private:
     FT_Face m_face;
-    Glyph m_glyphs[127];
+    Glyph m_glyphs[GlyphCount];
+    Texture m_atlas;
     int m_font_size;
 
-    Texture from_char(char c);
+    struct CachedRun {
+        TextRun run;
+        uint64_t last_use = 0;
+    };
+
+    mutable std::unordered_map<std::string, CachedRun> m_runs;
+    mutable uint64_t m_use_clock = 0;
+
+    std::vector<A565Color> from_char(char c);
+    void build_atlas(const std::vector<A565Color> *bitmaps);
 };
 }
@@ -0,0 +1,164 @@
+#include "HudLayer.h"
+
+#include <algorithm>
+
+namespace Graphics {
+
+int HudLayer::add_text(const TTFFont &font, const Point &position, const std::string &text) {
+    Widget widget;
+    widget.type = Widget::Type::Text;
+    widget.position = position;
+    widget.p_font = &font;
+    widget.text = text;
+
+    m_widgets.push_back(std::move(widget));
+    m_dirty = true;
+
+    return m_widgets.size() - 1;
+}
+
+int HudLayer::add_sprite(const BlitSurface &surface, const Rect &src, const Rect &dest) {
+    Widget widget;
+    widget.type = Widget::Type::Sprite;
+    widget.position = Point { dest.x_pos, dest.y_pos };
+    widget.p_surface = &surface;
+    widget.src = src;
+    widget.dest = dest;
+
+    m_widgets.push_back(std::move(widget));
+    m_dirty = true;
+
+    return m_widgets.size() - 1;
+}
+
+void HudLayer::set_text(int widget, const std::string &text) {
+    auto &current = m_widgets[widget].text;
+
+    if (current != text) {
+        current = text;
+        m_dirty = true;
+    }
+}
+
+void HudLayer::set_position(int widget, const Point &position) {
+    auto &current = m_widgets[widget].position;
+
+    if (current.x != position.x || current.y != position.y) {
+        current = position;
+        m_dirty = true;
+    }
+}
+
+void HudLayer::set_visible(int widget, bool visible) {
+    if (m_widgets[widget].visible != visible) {
+        m_widgets[widget].visible = visible;
+        m_dirty = true;
+    }
+}
+
+void HudLayer::invalidate() {
+    m_dirty = true;
+}
+
+void HudLayer::composite(const BlitTarget &target) {
+    update(target.width, target.height);
+
+    auto dst_pixels = reinterpret_cast<uint32_t*>(target.pixels);
+
+    for (int y = m_y_begin; y < m_y_end; y++)
+        composite_row(dst_pixels + target.width * y, y);
+}
+
+void HudLayer::update(int width, int height) {
+    if (m_dirty || m_layer.width != width || m_layer.height != height)
+        redraw(width, height);
+}
+
+void HudLayer::composite_row(uint32_t *dst_row, int y) const {
+    if (y < m_y_begin || y >= m_y_end)
+        return;
+
+    auto src_row = m_layer.pixels.data() + m_layer.width * y;
+    blend_row(dst_row + m_x_begin, src_row + m_x_begin, m_x_end - m_x_begin, BlendMode::Alpha);
+}
+
+void HudLayer::redraw(int width, int height) {
+    if (m_layer.width != width || m_layer.height != height) {
+        m_layer.width = width;
+        m_layer.height = height;
+        m_layer.pixels.assign(width * height, 0);
+    } else {
+        // only the part the widgets drew into last time can hold pixels
+        for (int y = m_y_begin; y < m_y_end; y++)
+            std::fill_n(m_layer.pixels.data() + width * y + m_x_begin, m_x_end - m_x_begin, 0);
+    }
+
+    m_x_begin = width;
+    m_y_begin = height;
+    m_x_end = 0;
+    m_y_end = 0;
+
+    BlitTarget layer_target { reinterpret_cast<Pixel*>(m_layer.pixels.data()), width, height };
+
+    for (const auto &widget : m_widgets) {
+        if (!widget.visible)
+            continue;
+
+        if (widget.type == Widget::Type::Text) {
+            draw_text(widget);
+        } else {
+            Rect dest = widget.dest;
+            dest.x_pos = widget.position.x;
+            dest.y_pos = widget.position.y;
+
+            blit(layer_target, *widget.p_surface, widget.src, dest, BlendMode::Alpha);
+            extend_bounds(dest.x_pos, dest.y_pos, dest.width, dest.height);
+        }
+    }
+
+    if (m_x_begin >= m_x_end || m_y_begin >= m_y_end)
+        m_x_begin = m_y_begin = m_x_end = m_y_end = 0;
+
+    m_dirty = false;
+}
+
+void HudLayer::draw_text(const Widget &widget) {
+    auto &font = *widget.p_font;
+    auto &run = font.layout_text(widget.text);
+    auto &atlas = font.get_atlas();
+    auto atlas_pixels = atlas.get_pixels();
+
+    for (auto &quad : run.quads) {
+        int x_pos = widget.position.x + quad.x_offset;
+        int y_pos = widget.position.y + quad.y_offset;
+
+        int x_begin = std::max(0, -x_pos);
+        int y_begin = std::max(0, -y_pos);
+        int x_end = std::min(quad.src.width, m_layer.width - x_pos);
+        int y_end = std::min(quad.src.height, m_layer.height - y_pos);
+
+        for (int y = y_begin; y < y_end; y++) {
+            auto src_row = atlas_pixels + atlas.width * (quad.src.y_pos + y) + quad.src.x_pos;
+            auto dest_row = m_layer.pixels.data() + m_layer.width * (y_pos + y) + x_pos;
+
+            for (int x = x_begin; x < x_end; x++) {
+                A565Color pixel = src_row[x];
+
+                // same alpha test as Renderer::render_text, covered pixels replace the scene
+                if ((pixel.value >> 24) > 0)
+                    dest_row[x] = pixel.rgba_bit() | 0xFF000000;
+            }
+        }
+
+        extend_bounds(x_pos, y_pos, quad.src.width, quad.src.height);
+    }
+}
+
+void HudLayer::extend_bounds(int x_pos, int y_pos, int width, int height) {
+    m_x_begin = std::min(m_x_begin, std::max(0, x_pos));
+    m_y_begin = std::min(m_y_begin, std::max(0, y_pos));
+    m_x_end = std::max(m_x_end, std::min(m_layer.width, x_pos + width));
+    m_y_end = std::max(m_y_end, std::min(m_layer.height, y_pos + height));
+}
+
+}
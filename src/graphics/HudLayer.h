@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Blitter.h"
+#include "Font.h"
+
+namespace Graphics {
+
+/*
+ * Retained overlay. Widgets are drawn into an offscreen layer that is only redrawn when one of
+ * them changes, every other frame the layer is blended onto the target in one pass over the
+ * area the widgets cover, no matter how many there are.
+ */
+class HudLayer {
+public:
+    HudLayer() = default;
+
+    HudLayer(const HudLayer &other) = delete;
+    HudLayer& operator=(const HudLayer &other) = delete;
+
+    /* the font has to outlive the layer, returns the id of the widget */
+    int add_text(const TTFFont &font, const Point &position, const std::string &text = "");
+
+    /* the surface has to outlive the layer */
+    int add_sprite(const BlitSurface &surface, const Rect &src, const Rect &dest);
+
+    /* nothing is redrawn when the text stays the same */
+    void set_text(int widget, const std::string &text);
+    void set_position(int widget, const Point &position);
+    void set_visible(int widget, bool visible);
+
+    /* the surface of a sprite changed its pixels */
+    void invalidate();
+
+    void composite(const BlitTarget &target);
+
+    /* redraws the layer when it changed or the size is different, call before composite_row */
+    void update(int width, int height);
+
+    /* blends row y of the layer onto dst_row, rows without widgets are skipped */
+    void composite_row(uint32_t *dst_row, int y) const;
+private:
+    struct Widget {
+        enum class Type {
+            Text,
+            Sprite,
+        } type;
+
+        bool visible = true;
+        Point position;
+
+        const TTFFont *p_font = nullptr;
+        std::string text;
+
+        const BlitSurface *p_surface = nullptr;
+        Rect src;
+        Rect dest;
+    };
+
+    std::vector<Widget> m_widgets;
+
+    BlitSurface m_layer;
+    bool m_dirty = true;
+
+    // area of the layer the widgets drew into, only this part is composited
+    int m_x_begin = 0, m_y_begin = 0;
+    int m_x_end = 0, m_y_end = 0;
+
+    void redraw(int width, int height);
+    void draw_text(const Widget &widget);
+    void extend_bounds(int x_pos, int y_pos, int width, int height);
+};
+
+}
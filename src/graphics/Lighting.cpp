@@ -1,11 +1,17 @@
+#include <algorithm>
+#include <cmath>
+
 #include "Lighting.h"
+#include "../math/Simd.h"
 
 namespace Graphics {
 int num_lights = 0;
-Light g_lights[MaxLights];
+std::vector<Light> g_lights;
+
+static uint32_t light_version_counter = 0;
 
 void reset_lights() {
-    std::memset(g_lights, 0, MaxLights * sizeof(Light));
+    g_lights.clear();
     num_lights = 0;
 }
 
@@ -17,10 +23,14 @@ int init_light(int index,
         float kc, float kl, float kq,
         float pf)
 {
-    if (index < 0 || index >= MaxLights) {
+    if (index < 0) {
         return -1;
     }
 
+    if (index >= (int)g_lights.size()) {
+        g_lights.resize(index + 1, Light {});
+    }
+
     g_lights[index].state = state;
     g_lights[index].id = index;
     g_lights[index].attributes = attributes;
@@ -37,7 +47,32 @@ int init_light(int index,
 
     g_lights[index].pf = pf;
 
-    num_lights++;
+    g_lights[index].radius = compute_light_radius(g_lights[index]);
+    g_lights[index].version = ++light_version_counter;
+
+    num_lights = g_lights.size();
+
+    return index;
+}
+
+int set_light_state(int index, uint16_t state) {
+    if (index < 0 || index >= num_lights) {
+        return -1;
+    }
+
+    g_lights[index].state = state;
+    g_lights[index].version = ++light_version_counter;
+
+    return index;
+}
+
+int set_light_pos(int index, Point4D pos) {
+    if (index < 0 || index >= num_lights) {
+        return -1;
+    }
+
+    g_lights[index].pos = pos;
+    g_lights[index].version = ++light_version_counter;
 
     return index;
 }
@@ -67,7 +102,90 @@ int create_base_point_light(int index, RGBA col, V4D pos, float kc, float kl, fl
             0);
 }
 
-void gourad_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights) {
+float compute_light_radius(const Light &light) {
+    if (!(light.attributes & LightAttributePoint))
+        return LightRadiusInfinite;
+
+    // brightest contribution of the light at distance d, facing it directly, is
+    // c * 255 / 256 / atten(d), solve kc + kl * d + kq * d^2 = c * 255 / 256 / LightCutoff for d
+    float c = std::max({ light.c_diffuse.r, light.c_diffuse.g, light.c_diffuse.b }) * 255 / 256.0f;
+    float atten = c / LightCutoff;
+
+    if (light.kc >= atten)
+        return 0;
+
+    if (light.kq > 0) {
+        float disc = light.kl * light.kl - 4 * light.kq * (light.kc - atten);
+
+        return (-light.kl + std::sqrt(disc)) / (2 * light.kq);
+    }
+
+    if (light.kl > 0)
+        return (atten - light.kc) / light.kl;
+
+    return LightRadiusInfinite;
+}
+
+void cull_lights_object(RenderObject &object, const Light *lights, int max_lights) {
+    static thread_local std::vector<int> light_list;
+    light_list.clear();
+
+    // the bounding sphere is centered on the local origin, see world_transform_object
+    auto &trans = object.transform;
+    V4D center(trans.pos.x * trans.scale.x, trans.pos.y * trans.scale.y, trans.pos.z * trans.scale.z);
+
+    float scale = std::max({ std::fabs(trans.scale.x), std::fabs(trans.scale.y), std::fabs(trans.scale.z) });
+    float radius = object.radius * scale;
+
+    for (int curr_light = 0; curr_light < max_lights; curr_light++) {
+        auto &light = lights[curr_light];
+
+        if (!light.state) {
+            continue;
+        }
+
+        if (light.radius != LightRadiusInfinite) {
+            float reach = light.radius + radius;
+
+            auto l = V4D(center, light.pos);
+
+            if (l.dot(l) > reach * reach)
+                continue;
+        }
+
+        light_list.push_back(curr_light);
+    }
+
+    bool dirty = light_list != object.light_list
+        || object.transform.version != object.lit_transform_version
+        || object.curr_frame != object.lit_frame
+        || (int)object.vertex_light_epochs.size() != object.vertex_count;
+
+    for (int i = 0; !dirty && i < (int)light_list.size(); i++)
+        dirty = lights[light_list[i]].version != object.light_versions[i];
+
+    if (!dirty)
+        return;
+
+    object.light_list.swap(light_list);
+
+    object.light_versions.clear();
+    for (int curr_light : object.light_list)
+        object.light_versions.push_back(lights[curr_light].version);
+
+    object.lit_transform_version = object.transform.version;
+    object.lit_frame = object.curr_frame;
+
+    object.vertex_light_epochs.resize(object.vertex_count, 0);
+
+    // epoch 0 is what new vertices start with, so it is never valid
+    if (++object.light_epoch == 0) {
+        std::fill(object.vertex_light_epochs.begin(), object.vertex_light_epochs.end(), 0);
+        object.light_epoch = 1;
+    }
+}
+
+void gourad_light_polygon(RenderListPoly &polygon, const Light *lights) {
     uint32_t r_base, g_base, b_base,
              r0_sum, g0_sum, b0_sum,
              r1_sum, g1_sum, b1_sum,
@@ -84,7 +202,9 @@ void gourad_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights
         r1_sum = g1_sum = b1_sum = 0;
         r2_sum = g2_sum = b2_sum = 0;
 
-        for (int curr_light = 0; curr_light < max_lights; curr_light++) {
+        for (int light_index = 0; light_index < polygon.light_count; light_index++) {
+            int curr_light = polygon.light_list[light_index];
+
             if (!lights[curr_light].state) {
                 continue;
             }
@@ -194,7 +314,7 @@ void gourad_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights
     }
 }
 
-void gourad_intensity_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights) {
+void gourad_intensity_light_polygon(RenderListPoly &polygon, const Light *lights) {
     uint32_t r_base, g_base, b_base,
              r0_sum,
              r1_sum,
@@ -211,7 +331,9 @@ void gourad_intensity_light_polygon(RenderListPoly &polygon, Light *lights, int
         r1_sum = 0;
         r2_sum = 0;
 
-        for (int curr_light = 0; curr_light < max_lights; curr_light++) {
+        for (int light_index = 0; light_index < polygon.light_count; light_index++) {
+            int curr_light = polygon.light_list[light_index];
+
             if (!lights[curr_light].state) {
                 continue;
             }
@@ -295,7 +417,7 @@ void gourad_intensity_light_polygon(RenderListPoly &polygon, Light *lights, int
     }
 }
 
-void flat_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights) {
+void flat_light_polygon(RenderListPoly &polygon, const Light *lights) {
     uint32_t r_base, g_base, b_base,
              r_sum,
              ri,
@@ -308,7 +430,9 @@ void flat_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights)
     if (polygon.attributes & PolyAttributeShadeModeIntensityGourad) {
         r_sum = 0;
 
-        for (int curr_light = 0; curr_light < max_lights; curr_light++) {
+        for (int light_index = 0; light_index < polygon.light_count; light_index++) {
+            int curr_light = polygon.light_list[light_index];
+
             if (!lights[curr_light].state) {
                 continue;
             }
@@ -349,4 +473,190 @@ void flat_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights)
         polygon.trans_verts[2].i = intensity;
     }
 }
+
+void bake_static_lighting(StaticRenderObject &object, const Light *lights, int max_lights) {
+    uint32_t r_base, g_base, b_base;
+    object.color.rgb888_from_16bit(r_base, g_base, b_base);
+
+    Matrix4x4 mat_rot = object.transform.get_rotation_matrix();
+
+    object.baked_intensities.assign(object.vertex_count, 0);
+
+    // same sums as light_object_vertices, so baked and runtime lighting look the same
+    for (int vertex = 0; vertex < object.vertex_count; vertex++) {
+        auto n = mat_rot.transform(object.local_vertices[vertex].n);
+        float sum = 0;
+
+        for (int curr_light = 0; curr_light < max_lights; curr_light++) {
+            auto &light = lights[curr_light];
+
+            if (!light.state) {
+                continue;
+            }
+
+            if (light.attributes & LightAttributeAmbient) {
+                sum += (light.c_ambient.r * r_base) >> 8;
+            } else if (light.attributes & LightAttributeInfinite) {
+                float dp = n.dot(light.dir);
+
+                if (dp > 0.0f)
+                    sum += dp * ((light.c_diffuse.r * r_base) / 256.0f);
+            }
+        }
+
+        object.baked_intensities[vertex] = sum / 255.0f;
+    }
+}
+
+struct VertexLightSetup {
+    // contributions are in the same 0..255 range the polygon lighting functions accumulate in
+    float ambient;
+
+    std::vector<const Light*> infinite;
+    std::vector<float> infinite_k;
+
+    std::vector<const Light*> point;
+    std::vector<float> point_k;
+
+    void clear() {
+        ambient = 0;
+
+        infinite.clear();
+        infinite_k.clear();
+        point.clear();
+        point_k.clear();
+    }
+};
+
+static void light_vertex_batch(const VertexLightSetup &setup,
+        const float *nx, const float *ny, const float *nz,
+        const float *px, const float *py, const float *pz,
+        const float *base, float *intensities)
+{
+    using namespace Math;
+
+    VFloat v_nx = v_load(nx);
+    VFloat v_ny = v_load(ny);
+    VFloat v_nz = v_load(nz);
+
+    VFloat zero = v_set(0.0f);
+    VFloat sum = v_add(v_load(base), v_set(setup.ambient));
+
+    for (int light = 0; light < (int)setup.infinite.size(); light++) {
+        auto &dir = setup.infinite[light]->dir;
+
+        VFloat dp = v_add(v_add(v_mul(v_nx, v_set(dir.x)), v_mul(v_ny, v_set(dir.y))), v_mul(v_nz, v_set(dir.z)));
+        sum = v_add(sum, v_mul(v_max(dp, zero), v_set(setup.infinite_k[light])));
+    }
+
+    if (!setup.point.empty()) {
+        VFloat v_px = v_load(px);
+        VFloat v_py = v_load(py);
+        VFloat v_pz = v_load(pz);
+
+        for (int light = 0; light < (int)setup.point.size(); light++) {
+            auto l_ptr = setup.point[light];
+
+            VFloat lx = v_sub(v_set(l_ptr->pos.x), v_px);
+            VFloat ly = v_sub(v_set(l_ptr->pos.y), v_py);
+            VFloat lz = v_sub(v_set(l_ptr->pos.z), v_pz);
+
+            VFloat dist_sq = v_add(v_add(v_mul(lx, lx), v_mul(ly, ly)), v_mul(lz, lz));
+            VFloat dist = v_sqrt(dist_sq);
+
+            VFloat dp = v_add(v_add(v_mul(v_nx, lx), v_mul(v_ny, ly)), v_mul(v_nz, lz));
+
+            VFloat atten = v_add(v_add(v_set(l_ptr->kc), v_mul(v_set(l_ptr->kl), dist)), v_mul(v_set(l_ptr->kq), dist_sq));
+            VFloat i = v_div(v_max(dp, zero), v_mul(dist, atten));
+
+            sum = v_add(sum, v_mul(i, v_set(setup.point_k[light])));
+        }
+    }
+
+    sum = v_min(sum, v_set(255.0f));
+    v_store(intensities, v_mul(sum, v_set(1.0f / 255.0f)));
+}
+
+void light_object_vertices(RenderObject &object, const uint8_t *vertex_refs,
+        int vertex_start, int vertex_end, const Light *lights)
+{
+    uint32_t r_base, g_base, b_base;
+    object.color.rgb888_from_16bit(r_base, g_base, b_base);
+
+    // sort the lights by type once, so the vertex loops don't have to branch on attributes
+    static thread_local VertexLightSetup setup;
+    setup.clear();
+
+    bool baked = !object.baked_intensities.empty();
+
+    for (int curr_light : object.light_list) {
+        auto &light = lights[curr_light];
+
+        if (baked && (light.attributes & (LightAttributeAmbient | LightAttributeInfinite))) {
+            continue;
+        }
+
+        if (light.attributes & LightAttributeAmbient) {
+            setup.ambient += (light.c_ambient.r * r_base) >> 8;
+        } else if (light.attributes & LightAttributeInfinite) {
+            setup.infinite.push_back(&light);
+            setup.infinite_k.push_back((light.c_diffuse.r * r_base) / 256.0f);
+        } else if (light.attributes & LightAttributePoint) {
+            setup.point.push_back(&light);
+            setup.point_k.push_back((light.c_diffuse.r * r_base) / 256.0f);
+        }
+    }
+
+    using Math::SimdWidth;
+
+    alignas(32) float nx[SimdWidth], ny[SimdWidth], nz[SimdWidth];
+    alignas(32) float px[SimdWidth], py[SimdWidth], pz[SimdWidth];
+    alignas(32) float base[SimdWidth], intensities[SimdWidth];
+    int indices[SimdWidth];
+
+    int batch = 0;
+
+    for (int vertex = vertex_start; vertex <= vertex_end; vertex++) {
+        bool last = vertex == vertex_end;
+
+        if (!last) {
+            if (!vertex_refs[vertex] || object.vertex_light_epochs[vertex] == object.light_epoch)
+                continue;
+
+            object.vertex_light_epochs[vertex] = object.light_epoch;
+
+            // gather the AoS vertex into the SoA batch
+            auto &trans_vert = object.transformed_vertices[vertex];
+
+            nx[batch] = trans_vert.n.x;
+            ny[batch] = trans_vert.n.y;
+            nz[batch] = trans_vert.n.z;
+
+            px[batch] = trans_vert.v.x;
+            py[batch] = trans_vert.v.y;
+            pz[batch] = trans_vert.v.z;
+
+            base[batch] = baked ? object.baked_intensities[vertex] * 255.0f : 0.0f;
+
+            indices[batch++] = vertex;
+        }
+
+        if (batch == 0 || (batch < SimdWidth && !last))
+            continue;
+
+        // pad a partial batch with its first vertex, the padded lanes are thrown away
+        for (int lane = batch; lane < SimdWidth; lane++) {
+            nx[lane] = nx[0]; ny[lane] = ny[0]; nz[lane] = nz[0];
+            px[lane] = px[0]; py[lane] = py[0]; pz[lane] = pz[0];
+            base[lane] = base[0];
+        }
+
+        light_vertex_batch(setup, nx, ny, nz, px, py, pz, base, intensities);
+
+        for (int lane = 0; lane < batch; lane++)
+            object.vertex_intensities[indices[lane]] = intensities[lane];
+
+        batch = 0;
+    }
+}
 }
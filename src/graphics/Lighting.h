@@ -1,7 +1,15 @@
+#pragma once
+
+#include <vector>
+
 #include "RenderObject.h"
 
 namespace Graphics {
-static constexpr int MaxLights = 8;
+// a light contributes less than one color step beyond its radius
+static constexpr float LightCutoff = 1.0f;
+
+// radius of lights that reach the whole scene: ambient, infinite and unattenuated point lights
+static constexpr float LightRadiusInfinite = -1.0f;
 
 typedef struct Light_Type {
     int id;
@@ -19,10 +27,16 @@ typedef struct Light_Type {
 
     float kc, kl, kq;
 
+    // distance at which the attenuation drops the light below LightCutoff, see compute_light_radius
+    float radius;
+
+    // changes whenever the light changes, objects lit by an older version get relit
+    uint32_t version;
+
     float pf;
 } Light;
 
-extern Light g_lights[MaxLights];
+extern std::vector<Light> g_lights;
 extern int num_lights;
 
 void reset_lights();
@@ -37,14 +51,48 @@ int init_light(int index,
         float spot_inner, float spot_outer,
         float pf);
 
+/* setters for lights that change at runtime, they invalidate the lighting of the objects they touch */
+int set_light_state(int index, uint16_t state);
+int set_light_pos(int index, Point4D pos);
+
 int create_base_amb_light(int index, RGBA col);
 int create_base_dir_light(int index, RGBA col, V4D dir);
 int create_base_point_light(int index, RGBA col, V4D pos, float kc, float kl, float kq);
 
-void gourad_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights);
+float compute_light_radius(const Light &light);
+
+/*
+ * Collects the lights whose radius intersects the bounding sphere of the object into
+ * object.light_list. Lights without radius always touch the object. When the list, the
+ * version of one of its lights, the transform or the frame of the object changed since the
+ * last call, the cached vertex intensities of the object are invalidated.
+ */
+void cull_lights_object(RenderObject &object, const Light *lights, int max_lights);
+
+/* the polygon lighting only evaluates the lights in polygon.light_list, the ones that touch its object */
+void gourad_light_polygon(RenderListPoly &polygon, const Light *lights);
+
+void gourad_intensity_light_polygon(RenderListPoly &polygon, const Light *lights);
+
+void flat_light_polygon(RenderListPoly &polygon, const Light *lights);
 
-void gourad_intensity_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights);
+/*
+ * Evaluates the ambient and infinite lights for every vertex of the current frame once and
+ * stores the result in object.baked_intensities. The polygons of baked objects enter the
+ * render list marked with PolyAttributeBakedLighting, so the pipeline won't light them again
+ * and only adds the point lights on top. The object must not move or rotate after baking.
+ */
+void bake_static_lighting(StaticRenderObject &object, const Light *lights, int max_lights);
 
-void flat_light_polygon(RenderListPoly &polygon, Light *lights, int max_lights);
+/*
+ * Lights the world space vertices in [vertex_start, vertex_end) that are marked in vertex_refs
+ * and writes the intensities to object.vertex_intensities. Every vertex is lit once, no matter
+ * how many polygons share it. Vertices that are still valid in the lighting cache of the object
+ * are skipped. Only the lights in object.light_list are evaluated, baked objects
+ * start from their baked intensities and skip the static lights. Normals are processed in SIMD
+ * batches with a separate loop per light type.
+ */
+void light_object_vertices(RenderObject &object, const uint8_t *vertex_refs,
+        int vertex_start, int vertex_end, const Light *lights);
 }
 
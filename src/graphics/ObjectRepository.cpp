@@ -9,30 +9,49 @@
 
 namespace Graphics {
 
-ObjectRepository::ObjectRepository() {}
+static Assets::AssetOptions mesh_load_options() {
+    Assets::AssetOptions options;
+    options.mesh_options.poly_attributes = PolyAttributeTwoSided | PolyAttributeRGB24 |
+            PolyAttributeShadeModeIntensityGourad | PolyAttributeShadeModeGouraud | PolyAttributeShadeModeTexture;
+    options.mesh_options.poly_state = PolyStateActive;
+    options.mesh_options.poly_color = A565Color(0xFF, 0, 0, 0).value;
+
+    return options;
+}
+
+static Assets::AssetOptions texture_load_options() {
+    Assets::AssetOptions options;
+    options.texture_options.mipmap = 1;
 
-ObjectRepository::~ObjectRepository() {
-    for (auto object : m_game_objects)
-        delete[] object.transformed_vertices;
+    return options;
 }
 
+ObjectRepository::ObjectRepository(Core::JobSystem *job_system) : m_cache(job_system) {}
+
+ObjectRepository::~ObjectRepository() {}
+
 RenderObject ObjectRepository::create_render_object(std::string mde_file) {
-    RenderObject object;
+    // every instance of a mesh shares the same loaded data
+    auto mesh = m_cache.acquire_mesh(mde_file);
+    if (mesh == nullptr) {
+        m_cache.load_asset(Assets::Asset::Type::Mde, mde_file, mesh_load_options());
+        mesh = m_cache.acquire_mesh(mde_file);
+    }
 
-    auto object_color = A565Color(0xFF, 0, 0, 0);
+    return create_render_object(mde_file, mesh);
+}
 
-    Assets::AssetOptions options;
-    options.mesh_options.poly_attributes = PolyAttributeTwoSided | PolyAttributeRGB24 |
-            PolyAttributeShadeModeIntensityGourad | PolyAttributeShadeModeGouraud | PolyAttributeShadeModeTexture;
-    options.mesh_options.poly_state = PolyStateActive;
-    options.mesh_options.poly_color = object_color.value;
+RenderObject ObjectRepository::create_render_object(std::string mde_file, Mesh *mesh) {
+    RenderObject object;
 
-    m_cache.load_asset(Assets::Asset::Type::Mde, mde_file, options);
-    auto mesh = m_cache.get_mesh(mde_file);
+    auto object_color = A565Color(0xFF, 0, 0, 0);
 
     auto objects_count = m_game_objects.size();
 
-    object.textures = load_mip_texture("assets/" + mesh->skins[0]);
+    object.mesh_asset = mde_file;
+    object.texture_asset = "assets/" + mesh->skins[0];
+
+    object.textures = load_mip_texture(object.texture_asset);
 
     object.mip_levels = object.textures.size();
 
@@ -52,29 +71,80 @@ RenderObject ObjectRepository::create_render_object(std::string mde_file) {
     object.local_vertices = mesh->vertices;
     object.alpha = 1.0f;
 
-    object.transformed_vertices = new Vertex4D[mesh->vertex_count];
+    object.radius = mesh->radius;
 
     object.text_count = mesh->text_count;
     object.texture_coords = mesh->text_coords;
 
     object.head_local_vertices = &object.local_vertices[0];
-    object.head_transformed_vertices = &object.transformed_vertices[0];
 
     object.color = object_color;
-    object.polygons = std::move(mesh->polygons);
+    object.polygons = mesh->polygons.data();
+    object.poly_count = mesh->polygons.size();
+
+    object.lods.push_back(MeshLod { object.polygons, object.poly_count });
+    for (const auto &lod : mesh->lods)
+        object.lods.push_back(MeshLod { lod.data(), (int)lod.size() });
 
     m_game_objects.push_back(object);
 
     return object;
 }
 
+void ObjectRepository::create_render_object_async(std::string mde_file, std::function<void(RenderObject&&)> on_ready) {
+    m_cache.load_asset_async(Assets::Asset::Type::Mde, mde_file, mesh_load_options(),
+            [this, on_ready](const std::string &name, bool success) {
+        if (!success)
+            return;
+
+        // the reference keeps the mesh in the cache until its skin is loaded, the object takes it over
+        auto mesh = m_cache.acquire_mesh(name);
+
+        // the skin is only known once the mesh is parsed
+        auto skin = "assets/" + mesh->skins[0];
+
+        m_cache.load_asset_async(Assets::Asset::Type::Texture, skin, texture_load_options(),
+                [this, name, mesh, on_ready](const std::string&, bool success) {
+            if (success)
+                on_ready(create_render_object(name, mesh));
+            else
+                m_cache.release(name);
+        });
+    });
+}
+
+void ObjectRepository::destroy_render_object(RenderObject &object) {
+    if (!object.mesh_asset.empty())
+        m_cache.release(object.mesh_asset);
+
+    if (!object.texture_asset.empty())
+        m_cache.release(object.texture_asset);
+
+    object.mesh_asset.clear();
+    object.texture_asset.clear();
+
+    object.textures.clear();
+    object.lods.clear();
+    object.polygons = nullptr;
+    object.poly_count = 0;
+    object.local_vertices = nullptr;
+    object.head_local_vertices = nullptr;
+    object.texture_coords = nullptr;
+    object.state = 0;
+}
+
+void ObjectRepository::update() {
+    m_cache.update();
+}
+
 std::vector<Texture*> ObjectRepository::load_mip_texture(std::string path) {
-    Assets::AssetOptions options;
-    options.texture_options.mipmap = 1;
+    auto textures = m_cache.acquire_textures(path);
+    if (!textures.empty())
+        return textures;
 
-    m_cache.load_asset(Assets::Asset::Type::Texture, path, options);
+    m_cache.load_asset(Assets::Asset::Type::Texture, path, texture_load_options());
 
-    return m_cache.get_textures(path);
+    return m_cache.acquire_textures(path);
 }
 
 int ObjectRepository::compute_vertex_normals(Graphics::Mesh &object) {
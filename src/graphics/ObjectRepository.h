@@ -4,6 +4,7 @@
 #include <array>
 #include <string>
 #include <unordered_map>
+#include <functional>
 
 #include "../io/MdeReader.h"
 #include "../assets/Cache.h"
@@ -47,7 +48,7 @@ class ObjCollection {
  */
 class ObjectRepository {
 public:
-    ObjectRepository();
+    ObjectRepository(Core::JobSystem *job_system = nullptr);
     ~ObjectRepository();
 
     ObjectRepository(const ObjectRepository &other) = delete;
@@ -58,10 +59,29 @@ public:
 
     RenderObject create_render_object(std::string mde_file);
 
+    /*
+     * Loads the mesh and its skin in the background and hands the object over from update
+     * once both are in the cache. Nothing is created when one of them fails to load.
+     */
+    void create_render_object_async(std::string mde_file, std::function<void(RenderObject&&)> on_ready);
+
+    /* gives the references of the object on its mesh and textures back to the cache */
+    void destroy_render_object(RenderObject &object);
+
+    /* publishes finished background loads, call it once per frame */
+    void update();
+
+    Assets::Cache& get_cache() {
+        return m_cache;
+    }
+
     std::vector<Texture*> load_mip_texture(std::string path);
 private:
     Assets::Cache m_cache;
 
+    /* builds the object around a mesh the caller already acquired, the object owns that reference */
+    RenderObject create_render_object(std::string mde_file, Mesh *mesh);
+
     int compute_vertex_normals(Graphics::Mesh &object);
 
     std::vector<RenderObject> m_game_objects;
@@ -0,0 +1,412 @@
+#include "PresentPass.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "../core/JobSystem.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Graphics {
+
+static constexpr int LutBits = 6;
+static constexpr int LutSize = 1 << LutBits;
+
+// rows presented by one job
+static constexpr int PresentRowsPerJob = 32;
+
+// how far the depth of last frame's pixel may lie outside the depths of the rows around it
+static constexpr float InterlaceDepthTolerance = 0.05f;
+
+ColorLut::ColorLut(int size) : m_size(size) {
+    m_entries.resize(size * size * size * 3);
+
+    for (int b = 0; b < size; b++) {
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                auto entry = &m_entries[((b * size + g) * size + r) * 3];
+
+                entry[0] = (float)r / (size - 1);
+                entry[1] = (float)g / (size - 1);
+                entry[2] = (float)b / (size - 1);
+            }
+        }
+    }
+}
+
+bool ColorLut::load_cube(const std::string &path) {
+    std::ifstream ifs(path);
+
+    if (!ifs.is_open()) {
+        std::cerr << "ColorLut::load_cube() Error: file " << path << " not found!" << std::endl;
+        return false;
+    }
+
+    int size = 0;
+    std::vector<float> entries;
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::stringstream ss(line);
+
+        if (std::isalpha(line[0])) {
+            std::string keyword;
+            ss >> keyword;
+
+            if (keyword == "LUT_3D_SIZE")
+                ss >> size;
+
+            continue;
+        }
+
+        float r, g, b;
+        if (ss >> r >> g >> b) {
+            entries.push_back(r);
+            entries.push_back(g);
+            entries.push_back(b);
+        }
+    }
+
+    if (size < 2 || entries.size() != (size_t)size * size * size * 3) {
+        std::cerr << "ColorLut::load_cube() Error: " << path << " is not a 3D lut" << std::endl;
+        return false;
+    }
+
+    m_size = size;
+    m_entries = std::move(entries);
+
+    return true;
+}
+
+void ColorLut::sample(float r, float g, float b, float &r_out, float &g_out, float &b_out) const {
+    float scale = m_size - 1;
+
+    float x = std::clamp(r, 0.0f, 1.0f) * scale;
+    float y = std::clamp(g, 0.0f, 1.0f) * scale;
+    float z = std::clamp(b, 0.0f, 1.0f) * scale;
+
+    int x0 = std::min((int)x, m_size - 2);
+    int y0 = std::min((int)y, m_size - 2);
+    int z0 = std::min((int)z, m_size - 2);
+
+    float fx = x - x0, fy = y - y0, fz = z - z0;
+
+    float result[3] = { 0, 0, 0 };
+
+    for (int corner = 0; corner < 8; corner++) {
+        int dx = corner & 1, dy = (corner >> 1) & 1, dz = corner >> 2;
+
+        float weight = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy) * (dz ? fz : 1 - fz);
+        auto entry = &m_entries[(((z0 + dz) * m_size + y0 + dy) * m_size + x0 + dx) * 3];
+
+        for (int i = 0; i < 3; i++)
+            result[i] += weight * entry[i];
+    }
+
+    r_out = result[0];
+    g_out = result[1];
+    b_out = result[2];
+}
+
+static uint32_t to_byte(float value) {
+    return std::clamp((int)(value * 255.0f + 0.5f), 0, 255);
+}
+
+void PresentPass::set_grading(float gamma, const ColorLut *lut) {
+    for (int i = 0; i < 256; i++) {
+        m_gamma_table[i] = to_byte(std::pow(i / 255.0f, 1.0f / gamma));
+
+        m_gamma_channels[0][i] = m_gamma_table[i] << 16;
+        m_gamma_channels[1][i] = m_gamma_table[i] << 8;
+        m_gamma_channels[2][i] = m_gamma_table[i];
+    }
+
+    if (lut == nullptr) {
+        m_grading = gamma == 1.0f ? Grading::None : Grading::Gamma;
+        m_lut_table.clear();
+
+        return;
+    }
+
+    m_grading = Grading::Lut;
+    m_lut_table.resize(LutSize * LutSize * LutSize);
+
+    // every entry is sampled in the middle of the colours that select it
+    auto center = [](int i) {
+        return ((i << (8 - LutBits)) + ((1 << (8 - LutBits)) - 1) * 0.5f) / 255.0f;
+    };
+
+    for (int r = 0; r < LutSize; r++) {
+        for (int g = 0; g < LutSize; g++) {
+            for (int b = 0; b < LutSize; b++) {
+                float r_out, g_out, b_out;
+                lut->sample(center(r), center(g), center(b), r_out, g_out, b_out);
+
+                m_lut_table[(r << (LutBits * 2)) | (g << LutBits) | b] =
+                    m_gamma_table[to_byte(r_out)] << 16 | m_gamma_table[to_byte(g_out)] << 8 | m_gamma_table[to_byte(b_out)];
+            }
+        }
+    }
+}
+
+void PresentPass::present_row(const uint32_t *src, uint32_t *dst, int width) const {
+    switch (m_grading) {
+        case Grading::None:
+            std::memcpy(dst, src, width * sizeof(uint32_t));
+            break;
+        case Grading::Gamma:
+            for (int x = 0; x < width; x++) {
+                uint32_t value = src[x];
+
+                dst[x] = (value & 0xFF000000) | m_gamma_channels[0][(value >> 16) & 0xFF]
+                    | m_gamma_channels[1][(value >> 8) & 0xFF] | m_gamma_channels[2][value & 0xFF];
+            }
+            break;
+        case Grading::Lut:
+            for (int x = 0; x < width; x++) {
+                uint32_t value = src[x];
+                uint32_t index = ((value >> (16 + 8 - LutBits)) & (LutSize - 1)) << (LutBits * 2)
+                    | ((value >> (8 + 8 - LutBits)) & (LutSize - 1)) << LutBits
+                    | ((value >> (8 - LutBits)) & (LutSize - 1));
+
+                dst[x] = (value & 0xFF000000) | m_lut_table[index];
+            }
+            break;
+    }
+}
+
+void PresentPass::set_upscale_filter(UpscaleFilter filter) {
+    m_filter = filter;
+}
+
+// source coordinate of the center of a destination pixel in 16.16 fixed point
+static int source_position(int dst, int src_size, int dst_size) {
+    int64_t position = ((int64_t)(2 * dst + 1) * src_size << 16) / (2 * dst_size) - (1 << 15);
+    return std::clamp<int64_t>(position, 0, (int64_t)(src_size - 1) << 16);
+}
+
+void PresentPass::prepare_scaling(int src_width, int dst_width) {
+    if (m_scale_src_width == src_width && m_scale_dst_width == dst_width)
+        return;
+
+    m_scale_src_width = src_width;
+    m_scale_dst_width = dst_width;
+
+    m_x_sources.resize(dst_width);
+    m_x_nearest.resize(dst_width);
+    m_x_weights.resize(dst_width * 8);
+
+    for (int x = 0; x < dst_width; x++) {
+        int position = source_position(x, src_width, dst_width);
+        uint16_t weight = (position >> 8) & 0xFF;
+
+        m_x_sources[x] = position >> 16;
+        m_x_nearest[x] = ((2 * x + 1) * src_width) / (2 * dst_width);
+
+        // the weights of both neighbours for the four channels, laid out like two unpacked pixels
+        std::fill_n(&m_x_weights[x * 8], 4, 256 - weight);
+        std::fill_n(&m_x_weights[x * 8 + 4], 4, weight);
+    }
+}
+
+static inline uint32_t lerp_pixel(uint32_t a, uint32_t b, uint32_t weight) {
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 32; shift += 8)
+        result |= ((((a >> shift) & 0xFF) * (256 - weight) + ((b >> shift) & 0xFF) * weight) >> 8) << shift;
+
+    return result;
+}
+
+void PresentPass::upscale_row(const uint32_t *row0, const uint32_t *row1, uint32_t y_weight, int frame_width,
+        uint32_t *dst, int width) const
+{
+    if (m_filter == UpscaleFilter::Nearest) {
+        for (int x = 0; x < width; x++)
+            dst[x] = row0[m_x_nearest[x]];
+
+        return;
+    }
+
+    // the two source rows blended first, with one more pixel so the last column has a neighbour
+    static thread_local std::vector<uint32_t> blended_row;
+    blended_row.resize(frame_width + 1);
+
+    int x = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w0 = _mm_set1_epi16(256 - y_weight);
+    const __m128i w1 = _mm_set1_epi16(y_weight);
+
+    for (; x + 4 <= frame_width; x += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x));
+
+        __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1)), 8);
+        __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1)), 8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(blended_row.data() + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; x < frame_width; x++)
+        blended_row[x] = lerp_pixel(row0[x], row1[x], y_weight);
+
+    blended_row[frame_width] = blended_row[frame_width - 1];
+
+    x = 0;
+
+#if defined(__SSE2__)
+    // both neighbours of a column are next to each other, one 64 bit load gets them
+    for (; x + 2 <= width; x += 2) {
+        __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(blended_row.data() + m_x_sources[x])), zero);
+        __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(blended_row.data() + m_x_sources[x + 1])), zero);
+
+        p0 = _mm_mullo_epi16(p0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_x_weights[x * 8])));
+        p1 = _mm_mullo_epi16(p1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_x_weights[x * 8 + 8])));
+
+        // left neighbours in the low halves, right ones in the high halves
+        __m128i left = _mm_unpacklo_epi64(p0, p1);
+        __m128i right = _mm_unpackhi_epi64(p0, p1);
+        __m128i sum = _mm_srli_epi16(_mm_add_epi16(left, right), 8);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(sum, zero));
+    }
+#endif
+
+    for (; x < width; x++) {
+        int src_x = m_x_sources[x];
+        dst[x] = lerp_pixel(blended_row[src_x], blended_row[src_x + 1], m_x_weights[x * 8 + 4]);
+    }
+}
+
+// rounds up like _mm_avg_epu8
+static inline uint32_t average_pixel(uint32_t a, uint32_t b) {
+    return (a | b) - (((a ^ b) & 0xFEFEFEFE) >> 1);
+}
+
+static void reconstruct_row(const uint32_t *frame, const InterlacedFrame &interlaced, int width, int height,
+        int y, uint32_t *dst)
+{
+    // the rows around this one belong to the current field, at the edges there is only one
+    int y_above = y > 0 ? y - 1 : y + 1;
+    int y_below = y + 1 < height ? y + 1 : y - 1;
+
+    auto old_row = frame + width * y;
+    auto above = frame + width * y_above;
+    auto below = frame + width * y_below;
+
+    auto old_z = interlaced.inv_z_buffer + width * y;
+    auto above_z = interlaced.inv_z_buffer + width * y_above;
+    auto below_z = interlaced.inv_z_buffer + width * y_below;
+
+    int x = 0;
+
+#if defined(__SSE2__)
+    const __m128 v_low = _mm_set1_ps(1.0f - InterlaceDepthTolerance);
+    const __m128 v_high = _mm_set1_ps(1.0f + InterlaceDepthTolerance);
+
+    for (; x + 4 <= width; x += 4) {
+        __m128 z0 = _mm_loadu_ps(above_z + x);
+        __m128 z1 = _mm_loadu_ps(below_z + x);
+        __m128 z = _mm_loadu_ps(old_z + x);
+
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(z, _mm_mul_ps(_mm_min_ps(z0, z1), v_low)),
+                _mm_cmple_ps(z, _mm_mul_ps(_mm_max_ps(z0, z1), v_high)));
+        __m128i keep = _mm_castps_si128(inside);
+
+        __m128i old_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(old_row + x));
+        __m128i average = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(above + x)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + x)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                _mm_or_si128(_mm_and_si128(keep, old_pixels), _mm_andnot_si128(keep, average)));
+    }
+#endif
+
+    for (; x < width; x++) {
+        float z_min = std::min(above_z[x], below_z[x]) * (1.0f - InterlaceDepthTolerance);
+        float z_max = std::max(above_z[x], below_z[x]) * (1.0f + InterlaceDepthTolerance);
+
+        if (old_z[x] >= z_min && old_z[x] <= z_max)
+            dst[x] = old_row[x];
+        else
+            dst[x] = average_pixel(above[x], below[x]);
+    }
+}
+
+void PresentPass::present(const Pixel *frame, int frame_width, int frame_height, uint32_t *screen, int width, int height,
+        HudLayer *overlay, Core::JobSystem *job_system, const InterlacedFrame *interlaced)
+{
+    // the layer is redrawn here, the rows only read it
+    if (overlay != nullptr)
+        overlay->update(width, height);
+
+    auto src = reinterpret_cast<const uint32_t*>(frame);
+
+    bool scaled = frame_width != width || frame_height != height;
+    if (scaled)
+        prepare_scaling(frame_width, width);
+
+    // a row of the frame, rebuilt into the buffer when it belongs to the field that wasn't drawn
+    auto frame_row = [&](int y, std::vector<uint32_t> &buffer) -> const uint32_t* {
+        if (interlaced == nullptr || (y & 1) == interlaced->field || frame_height < 2)
+            return src + frame_width * y;
+
+        buffer.resize(frame_width);
+        reconstruct_row(src, *interlaced, frame_width, frame_height, y, buffer.data());
+
+        return buffer.data();
+    };
+
+    auto present_rows = [&](int begin, int end, int) {
+        static thread_local std::vector<uint32_t> scaled_row;
+        static thread_local std::vector<uint32_t> rebuilt_rows[2];
+
+        for (int y = begin; y < end; y++) {
+            if (!scaled) {
+                present_row(frame_row(y, rebuilt_rows[0]), screen + width * y, width);
+            } else if (m_filter == UpscaleFilter::Nearest) {
+                auto row = frame_row(((2 * y + 1) * frame_height) / (2 * height), rebuilt_rows[0]);
+
+                scaled_row.resize(width);
+                upscale_row(row, row, 0, frame_width, scaled_row.data(), width);
+                present_row(scaled_row.data(), screen + width * y, width);
+            } else {
+                int position = source_position(y, frame_height, height);
+                int y0 = position >> 16;
+                int y1 = std::min(y0 + 1, frame_height - 1);
+
+                auto row0 = frame_row(y0, rebuilt_rows[0]);
+                auto row1 = frame_row(y1, rebuilt_rows[1]);
+
+                scaled_row.resize(width);
+                upscale_row(row0, row1, (position >> 8) & 0xFF, frame_width, scaled_row.data(), width);
+                present_row(scaled_row.data(), screen + width * y, width);
+            }
+
+            if (overlay != nullptr)
+                overlay->composite_row(screen + width * y, y);
+        }
+    };
+
+    if (job_system != nullptr)
+        job_system->parallel_for(height, PresentRowsPerJob, present_rows);
+    else
+        present_rows(0, height, 0);
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "HudLayer.h"
+
+namespace Core {
+class JobSystem;
+}
+
+namespace Graphics {
+
+/* 3D colour table, size entries on every axis with red changing fastest like in .cube files */
+class ColorLut {
+public:
+    /* identity table */
+    explicit ColorLut(int size = 17);
+
+    /* reads an Adobe .cube file, only 3D tables with the default domain are supported */
+    bool load_cube(const std::string &path);
+
+    /* trilinear lookup, the channels are in the 0 to 1 range */
+    void sample(float r, float g, float b, float &r_out, float &g_out, float &b_out) const;
+
+    int get_size() const {
+        return m_size;
+    }
+private:
+    int m_size;
+    std::vector<float> m_entries; // rgb triplets
+};
+
+/* the depth of the frame and the parity of the rows that were drawn into it this time */
+struct InterlacedFrame {
+    const float *inv_z_buffer;
+    int field;
+};
+
+enum class UpscaleFilter {
+    Nearest,
+    Bilinear,
+};
+
+/*
+ * Last pass of a frame. Grading, the colour conversion into the screen image and the 2D
+ * overlays are applied to a row while it is in the cache, so the frame is read and the screen
+ * written once no matter how many of them are enabled.
+ */
+class PresentPass {
+public:
+    PresentPass() = default;
+
+    PresentPass(const PresentPass &other) = delete;
+    PresentPass& operator=(const PresentPass &other) = delete;
+
+    /* gamma 1 and no lut turn grading off, the lut is baked and doesn't have to stay alive */
+    void set_grading(float gamma, const ColorLut *lut = nullptr);
+
+    void set_upscale_filter(UpscaleFilter filter);
+
+    /*
+     * The frame is frame_width * frame_height and gets scaled up to the screen when it is smaller.
+     * Overlays are blended after grading at the size of the screen, the ui keeps its colours.
+     * When interlaced is given, the rows of the other field still hold the last frame. A pixel
+     * from there is kept where its depth fits the rows around it, otherwise those are averaged.
+     */
+    void present(const Pixel *frame, int frame_width, int frame_height, uint32_t *screen, int width, int height,
+            HudLayer *overlay = nullptr, Core::JobSystem *job_system = nullptr,
+            const InterlacedFrame *interlaced = nullptr);
+private:
+    enum class Grading {
+        None,
+        Gamma,
+        Lut,
+    } m_grading = Grading::None;
+
+    uint8_t m_gamma_table[256];
+
+    // the gamma table already shifted to the red, green and blue bits of a pixel
+    uint32_t m_gamma_channels[3][256];
+
+    // the lut and gamma baked together, 6 bits of every channel select an entry
+    std::vector<uint32_t> m_lut_table;
+
+    UpscaleFilter m_filter = UpscaleFilter::Bilinear;
+
+    // source column and bilinear weights of every screen column, rebuilt when a size changes
+    int m_scale_src_width = 0;
+    int m_scale_dst_width = 0;
+    std::vector<int> m_x_sources;
+    std::vector<int> m_x_nearest;
+    std::vector<uint16_t> m_x_weights;
+
+    void prepare_scaling(int src_width, int dst_width);
+    void upscale_row(const uint32_t *row0, const uint32_t *row1, uint32_t y_weight, int frame_width,
+            uint32_t *dst, int width) const;
+    void present_row(const uint32_t *src, uint32_t *dst, int width) const;
+};
+
+}
@@ -116,6 +116,11 @@ struct PTFSINVZBEdge {
     }
 };
 
+// in interlaced mode only the rows of the current field get pixels, the present pass rebuilds the others
+static inline bool skip_row(const RenderContext &rc, int y) {
+    return rc.draw_field && (y & 1) != rc.interlace_field;
+}
+
 void scan_edges(PTFSINVZBEdge &long_edge, PTFSINVZBEdge &short_edge, bool handedness, A565Color color, const RenderListPoly &poly, RenderContext &rc) {
     float *iz_ptr;
     Pixel *screen_buffer_ptr;
@@ -169,6 +174,9 @@ void scan_edges(PTFSINVZBEdge &long_edge, PTFSINVZBEdge &short_edge, bool handed
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -378,6 +386,9 @@ void scan_edges(PTIINVZBEdge &long_edge, PTIINVZBEdge &short_edge, bool handedne
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (y * rc.max_clip_x);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -519,6 +530,9 @@ void scan_edges(PTIINVZBEdge &long_edge, PTIINVZBEdge &short_edge, bool handedne
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (y * rc.max_clip_x);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -730,6 +744,9 @@ void scan_edges(PTFSEdge &long_edge, PTFSEdge &short_edge, bool handedness, A565
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         for(int x = x_start + 1; x < x_end; x++) {
             auto pixel = poly.texture->get_pixel_by_shift((iu / iz) * poly.texture->width -1 + 0.5f, (iv / iz) * poly.texture->width -1 + 0.5f);
             pixel.rgb565_from_16bit(r, g, b);
@@ -930,6 +947,9 @@ void scan_edges(PTIEdge &long_edge, PTIEdge &short_edge, bool handedness, A565Co
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         screen_buffer_ptr = rc.frame_buffer + (y * rc.max_clip_x);
 
         for(int x = x_start + 1; x < x_end; x++) {
@@ -1145,6 +1165,9 @@ void scan_edges(PPTFSINVZBEdge &long_edge, PPTFSINVZBEdge &short_edge, bool hand
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -1362,6 +1385,9 @@ void scan_edges(PPTIINVZBEdge &long_edge, PPTIINVZBEdge &short_edge, bool handed
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -1510,6 +1536,9 @@ void scan_edges(PPTIINVZBEdge &long_edge, PPTIINVZBEdge &short_edge, bool handed
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -1733,6 +1762,9 @@ void scan_edges(PPTFSEdge &long_edge, PPTFSEdge &short_edge, bool handedness, A5
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         screen_buffer_ptr = rc.frame_buffer + y_pixel_offset;
@@ -1945,6 +1977,9 @@ void scan_edges(PPTIEdge &long_edge, PPTIEdge &short_edge, bool handedness, A565
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         screen_buffer_ptr = rc.frame_buffer + (rc.max_clip_x * y);
 
         for(int x = x_start + 1; x < x_end; x++) {
@@ -2152,6 +2187,9 @@ void scan_edges(ATFSINVZBEdge &long_edge, ATFSINVZBEdge &short_edge, bool handed
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -2359,6 +2397,9 @@ void scan_edges(ATIINVZBEdge &long_edge, ATIINVZBEdge &short_edge, bool handedne
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -2499,6 +2540,9 @@ void scan_edges(ATIINVZBEdge &long_edge, ATIINVZBEdge &short_edge, bool handedne
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -2683,6 +2727,9 @@ void scan_edges(ATFSEdge &long_edge, ATFSEdge &short_edge, bool handedness, A565
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         screen_buffer_ptr = rc.frame_buffer + y_pixel_offset;
@@ -2855,6 +2902,9 @@ void scan_edges(ATIEdge &long_edge, ATIEdge &short_edge, bool handedness, A565Co
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -2997,6 +3047,9 @@ void scan_edges(SEdge &long_edge, SEdge &short_edge, bool handedness, A565Color
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         screen_buffer_ptr = rc.frame_buffer + y_pixel_offset;
@@ -3123,6 +3176,9 @@ void scan_edges(FSEdge &long_edge, FSEdge &short_edge, bool handedness, A565Colo
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         screen_buffer_ptr = rc.frame_buffer + y_pixel_offset;
@@ -3255,6 +3311,9 @@ void scan_edges(IEdge &long_edge, IEdge &short_edge, bool handedness, A565Color
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -3406,6 +3465,9 @@ void scan_edges(SINVZBEdge &long_edge, SINVZBEdge &short_edge, bool handedness,
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         screen_buffer_ptr = rc.frame_buffer + y_pixel_offset;
@@ -3566,6 +3628,9 @@ void scan_edges(FSINVZBEdge &long_edge, FSINVZBEdge &short_edge, bool handedness
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -3725,6 +3790,9 @@ void scan_edges(IINVZBEdge &long_edge, IINVZBEdge &short_edge, bool handedness,
         if (x_end > rc.max_clip_x)
             x_end = rc.max_clip_x;
 
+        if (skip_row(rc, y))
+            x_end = x_start;
+
         auto y_pixel_offset = (rc.max_clip_x * y);
 
         iz_ptr = rc.inv_z_buffer + y_pixel_offset;
@@ -28,7 +28,6 @@ int RenderObject_Type::set_frame(int frame) {
     this->curr_frame = frame;
 
     this->local_vertices = &(this->head_local_vertices[frame * this->vertex_count]);
-    this->transformed_vertices = &(this->head_transformed_vertices[frame * this->vertex_count]);
 
     return 1;
 }
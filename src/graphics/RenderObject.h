@@ -38,6 +38,7 @@ const uint16_t PolyAttributeShadeModeConstant = 1 << 8;
 const uint16_t PolyAttributeShadeModeTexture = 1 << 9;
 const uint16_t PolyAttributeEnableMaterial = 1 << 10;
 const uint16_t PolyAttributeDisableMaterial = 1 << 11;
+const uint16_t PolyAttributeBakedLighting = 1 << 12;
 
 const uint16_t MaterialStateTransparent = 1 << 1;
 const uint16_t MaterialStateEightBitColor = 1 << 2;
@@ -124,7 +125,8 @@ typedef struct Polygon_Type {
     int vert[3];
     int text[3];
     float n_length;
-    // TODO can be deleted when using the RenderListPoly at this stage
+
+    // face normal in object space, computed once when the mesh is loaded
     V4D normal;
 } Polygon;
 
@@ -143,12 +145,22 @@ typedef struct RenderListPoly_Type {
     float avg_z;
     Vertex4D verts[3];
     Vertex4D trans_verts[3];
+
+    // lights that touch the object of the polygon, points into its light_list for the frame
+    const int *light_list;
+    int light_count;
 } RenderListPoly;
 
+typedef struct MeshLod_Type {
+    const Polygon *polygons;
+    int poly_count;
+} MeshLod;
+
 struct StaticRenderObject {
     int state;
     int attributes;
 
+    // bounding sphere around the local origin, in unscaled local space
     float radius;
 
     int vertex_count;
@@ -165,7 +177,20 @@ struct StaticRenderObject {
     Vertex4D *local_vertices;
     Point2D *texture_coords;
 
-    std::vector<Polygon> polygons;
+    // shared with every other instance of the mesh, never written by the pipeline
+    const Polygon *polygons;
+    int poly_count;
+
+    // levels of detail of the mesh, lods[0] is the full mesh. polygons points to the selected level.
+    std::vector<MeshLod> lods;
+
+    // intensities of the static lights per vertex, see bake_static_lighting. Not clamped,
+    // so dynamic lights can be added on top.
+    std::vector<float> baked_intensities;
+
+    // cache entries the instance holds a reference on, see ObjectRepository::destroy_render_object
+    std::string mesh_asset;
+    std::string texture_asset;
 };
 
 typedef struct RenderObject_Type : public StaticRenderObject {
@@ -177,10 +202,26 @@ typedef struct RenderObject_Type : public StaticRenderObject {
     int frames_count;
     int curr_frame;
 
-    Vertex4D *transformed_vertices;
-
     Vertex4D *head_local_vertices;
-    Vertex4D *head_transformed_vertices;
+
+    // Per frame scratch of the instance, borrowed from a ScratchPool while the pipeline
+    // transforms it. Both are indexed like the current frame of the mesh.
+    Vertex4D *transformed_vertices = nullptr;
+    uint16_t *poly_states = nullptr;
+
+    // per vertex light intensities of the current frame, see light_object_vertices
+    std::vector<float> vertex_intensities;
+
+    // indices of the lights that touch the object this frame, see cull_lights_object
+    std::vector<int> light_list;
+
+    // Lighting cache. A vertex intensity is valid while its epoch matches light_epoch,
+    // the epoch moves on when the lights, the transform or the frame change.
+    std::vector<uint32_t> light_versions;
+    std::vector<uint32_t> vertex_light_epochs;
+    uint32_t light_epoch = 0;
+    uint64_t lit_transform_version = 0;
+    int lit_frame = -1;
 
     int set_frame(int frame);
 
@@ -201,6 +242,12 @@ typedef struct MeshType {
     std::vector<Polygon> polygons;
     std::vector<std::string> skins;
 
+    // reduced levels of detail, they share the vertices with polygons
+    std::vector<std::vector<Polygon>> lods;
+
+    // bounding sphere around the origin over all frames
+    float radius;
+
     MeshType() = default;
     MeshType(const MeshType &other) {
         vertex_count = other.vertex_count;
@@ -210,6 +257,8 @@ typedef struct MeshType {
         std::memcpy(text_coords, other.text_coords, text_count);
 
         polygons = other.polygons;
+        lods = other.lods;
+        radius = other.radius;
     }
 
     MeshType(MeshType &&other) {
@@ -220,6 +269,8 @@ typedef struct MeshType {
         text_coords = other.text_coords;
 
         polygons = std::move(other.polygons);
+        lods = std::move(other.lods);
+        radius = other.radius;
     }
 
     MeshType& operator=(const MeshType &other) {
@@ -284,6 +335,13 @@ constexpr const uint32_t RCAttributeTextureCorrect =    1 << 6;
 constexpr const uint32_t RCAttributeTexturePiecewise =  1 << 7;
 constexpr const uint32_t RCAttributeTextureHybrid =     1 << 8;
 
+constexpr const uint32_t RCAttributeParallel =          1 << 9;
+constexpr const uint32_t RCAttributeVertexLighting =    1 << 10;
+constexpr const uint32_t RCAttributeLevelOfDetail =     1 << 11;
+
+// every frame fills either the even or the odd rows, see RenderContext::interlace_field
+constexpr const uint32_t RCAttributeInterlaced =        1 << 12;
+
 struct RenderContext {
     int attributes;
     int mip_z_dist;
@@ -299,6 +357,16 @@ struct RenderContext {
 
     int min_clip_y;
     int max_clip_y;
+
+    // parity of the rows drawn this frame when interlaced
+    int interlace_field = 0;
+
+    // The other field holds the last frame at the current resolution. Cleared whenever the buffers
+    // change size, the next frame is then drawn whole before the fields take turns again.
+    bool interlace_history = false;
+
+    // set by the pipeline, only the rows of interlace_field are drawn this frame and the others rebuilt
+    bool draw_field = false;
 };
 }
 
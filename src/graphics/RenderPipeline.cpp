@@ -11,50 +11,264 @@ enum ClipCodes : uint16_t {
     I = 0x0004,
 };
 
-RenderPipeline::RenderPipeline(Renderer *renderer) : p_renderer(renderer) {
+// Amount of polygons and vertices handed to a worker at once in parallel mode
+static constexpr int ParallelPolyChunk = 1024;
+static constexpr int ParallelVertexChunk = 2048;
+
+// objects with at least this many polygons are split into chunks instead of sharing a job with others
+static constexpr int ParallelLargeObject = 2 * ParallelPolyChunk;
+
+static void mark_referenced_vertices(const RenderObject &object, std::vector<uint8_t> &vertex_refs);
+static void world_transform_vertices(RenderObject &object, const uint8_t *vertex_refs,
+        int vertex_start, int vertex_end, CoordSelect coord_select);
+
+RenderPipeline::RenderPipeline(Renderer *renderer, Core::JobSystem *job_system)
+    : p_renderer(renderer), p_job_system(job_system) {
 
 }
 
-void RenderPipeline::render_objects(const Camera &camera, std::vector<RenderObject> renderables, RenderContext &rc) {
+void RenderPipeline::render_objects(const Camera &camera, std::vector<RenderObject> &renderables, RenderContext &rc) {
     rc.frame_buffer = p_renderer->get_framebuffer();
 
-    std::fill(rc.inv_z_buffer, rc.inv_z_buffer + rc.max_clip_x * rc.max_clip_y, 0);
-    p_renderer->clear_screen();
+    // without a last frame of the same size there is nothing to rebuild the other field from
+    rc.draw_field = (rc.attributes & RCAttributeInterlaced) && rc.interlace_history;
+    rc.interlace_history = rc.attributes & RCAttributeInterlaced;
+
+    if (rc.draw_field) {
+        // the other field keeps the pixels and depth of the last frame to rebuild its rows from
+        for (int y = rc.interlace_field; y < rc.max_clip_y; y += 2)
+            std::fill_n(rc.inv_z_buffer + rc.max_clip_x * y, rc.max_clip_x, 0);
+
+        p_renderer->clear_field(rc.interlace_field);
+    } else {
+        std::fill(rc.inv_z_buffer, rc.inv_z_buffer + rc.max_clip_x * rc.max_clip_y, 0);
+        p_renderer->clear_screen();
+    }
 
     auto vp = camera.get_view_projection();
     camera_transform_lights(vp);
 
     rc.render_list = std::vector<RenderListPoly>();
 
-    for (auto object : renderables) {
-        world_transform_object(object);
+    bool parallel = (rc.attributes & RCAttributeParallel) && p_job_system != nullptr
+        && p_job_system->get_num_threads() > 1;
 
-        backface_removal_object(object, camera);
+    // the level of detail decides how much work an object is, so it is picked before the objects are split up
+    if (rc.attributes & RCAttributeLevelOfDetail) {
+        for (auto &object : renderables) {
+            if ((object.state & ObjectStateActive) && (object.state & ObjectStateVisible))
+                select_lod_object(object, vp, rc);
+        }
+    }
 
-        camera_trans_to_renderlist(object, vp, rc);
+    if (parallel) {
+        transform_objects_parallel(camera, vp, renderables, rc);
+    } else {
+        for (auto &object : renderables)
+            transform_object(object, camera, vp, rc, false, m_vertex_refs, rc.render_list);
     }
 
     frustrum_clip_renderlist(camera, rc);
 
-    light_renderlist(rc);
+    for_each_chunk(parallel, rc.render_list.size(), ParallelPolyChunk, [&](int begin, int end, int) {
+        light_renderlist(rc, begin, end);
+    });
 
     if (rc.attributes & RCAttributeZSort) {
         std::sort(rc.render_list.begin(), rc.render_list.end(), &render_polygon_avg_sort);
     }
 
-    perspective_screen_transform_renderlist(camera, rc);
+    for_each_chunk(parallel, rc.render_list.size(), ParallelPolyChunk, [&](int begin, int end, int) {
+        perspective_screen_transform_renderlist(camera, rc, begin, end);
+    });
 
     draw_renderlist(rc);
 }
 
-void world_transform_object(RenderObject &object, CoordSelect coord_select) {
+void RenderPipeline::for_each_chunk(bool parallel, int count, int chunk_size, const Core::JobSystem::RangeFn &fn) {
+    if (parallel) {
+        p_job_system->parallel_for(count, chunk_size, fn);
+    } else if (count > 0) {
+        fn(0, count, 0);
+    }
+}
+
+void RenderPipeline::transform_objects_parallel(const Camera &camera, const Matrix4x4 &vp,
+        std::vector<RenderObject> &renderables, RenderContext &rc)
+{
+    // Small objects are grouped into batches of about ParallelPolyChunk polygons, one job each.
+    // Large meshes get a batch of their own and are split into chunks instead.
+    m_batches.clear();
+
+    int num_objects = renderables.size();
+    int batch_polys = 0;
+
+    for (int i = 0; i < num_objects; i++) {
+        auto &object = renderables[i];
+        if (!(object.state & ObjectStateActive) || !(object.state & ObjectStateVisible))
+            continue;
+
+        if (object.poly_count >= ParallelLargeObject) {
+            m_batches.push_back({ i, i + 1, true });
+            batch_polys = 0;
+            continue;
+        }
+
+        if (m_batches.empty() || m_batches.back().large || batch_polys >= ParallelPolyChunk) {
+            m_batches.push_back({ i, i + 1, false });
+            batch_polys = 0;
+        }
+
+        m_batches.back().end = i + 1;
+        batch_polys += object.poly_count;
+    }
+
+    int num_batches = m_batches.size();
+    if ((int)m_batch_lists.size() < num_batches)
+        m_batch_lists.resize(num_batches);
+
+    Core::JobCounter counter;
+
+    for (int b = 0; b < num_batches; b++) {
+        if (m_batches[b].large)
+            continue;
+
+        p_job_system->submit([this, b, &camera, &vp, &renderables, &rc] {
+            // the job never waits, so nothing else runs on this thread while it uses the buffer
+            static thread_local std::vector<uint8_t> vertex_refs;
+
+            auto &batch = m_batches[b];
+            auto &render_list = m_batch_lists[b];
+            render_list.clear();
+
+            for (int i = batch.begin; i < batch.end; i++)
+                transform_object(renderables[i], camera, vp, rc, false, vertex_refs, render_list);
+        }, &counter);
+    }
+
+    // the large meshes are split up from here while the workers take the batches
+    for (int b = 0; b < num_batches; b++) {
+        if (!m_batches[b].large)
+            continue;
+
+        m_batch_lists[b].clear();
+        transform_object(renderables[m_batches[b].begin], camera, vp, rc, true, m_vertex_refs, m_batch_lists[b]);
+    }
+
+    p_job_system->wait(counter);
+
+    // appended in the order of the objects to keep the output the same as the serial path
+    size_t num_polys = rc.render_list.size();
+    for (int b = 0; b < num_batches; b++)
+        num_polys += m_batch_lists[b].size();
+
+    rc.render_list.reserve(num_polys);
+
+    for (int b = 0; b < num_batches; b++)
+        rc.render_list.insert(rc.render_list.end(), m_batch_lists[b].begin(), m_batch_lists[b].end());
+}
+
+void RenderPipeline::transform_object(RenderObject &object, const Camera &camera, const Matrix4x4 &vp,
+        RenderContext &rc, bool parallel, std::vector<uint8_t> &vertex_refs, std::vector<RenderListPoly> &render_list)
+{
     if (!(object.state & ObjectStateActive) || !(object.state & ObjectStateVisible))
         return;
 
+    int poly_count = object.poly_count;
+
+    // the scratch only has to live until the polygons are copied into the render list
+    auto scratch = m_scratch_pool.acquire(object.vertex_count, poly_count);
+    object.transformed_vertices = scratch->transformed_vertices.data();
+    object.poly_states = scratch->poly_states.data();
+
+    transform_instance(object, camera, vp, rc, parallel, vertex_refs, render_list);
+
+    object.transformed_vertices = nullptr;
+    object.poly_states = nullptr;
+    m_scratch_pool.release(scratch);
+}
+
+void RenderPipeline::transform_instance(RenderObject &object, const Camera &camera, const Matrix4x4 &vp,
+        RenderContext &rc, bool parallel, std::vector<uint8_t> &vertex_refs, std::vector<RenderListPoly> &render_list)
+{
+    int poly_count = object.poly_count;
+
+    for_each_chunk(parallel, poly_count, ParallelPolyChunk, [&](int begin, int end, int) {
+        backface_removal_object(object, camera, begin, end);
+    });
+
+    mark_referenced_vertices(object, vertex_refs);
+
+    bool vertex_lighting = rc.attributes & RCAttributeVertexLighting;
+
+    // both lighting modes only evaluate the lights that reach the object
+    cull_lights_object(object, g_lights.data(), num_lights);
+
+    if (vertex_lighting) {
+        object.vertex_intensities.resize(object.vertex_count);
+        object.state |= ObjectStateLit;
+    } else if (object.state & ObjectStateLit) {
+        object.state ^= ObjectStateLit;
+    }
+
+    for_each_chunk(parallel, object.vertex_count, ParallelVertexChunk, [&](int begin, int end, int) {
+        world_transform_vertices(object, vertex_refs.data(), begin, end, CoordSelect::Local_To_Trans);
+
+        if (vertex_lighting) {
+            light_object_vertices(object, vertex_refs.data(), begin, end, g_lights.data());
+        }
+    });
+
+    if (!parallel) {
+        camera_trans_to_renderlist(object, vp, rc, 0, poly_count, render_list);
+        return;
+    }
+
+    // Every chunk writes into its own fragment of the render list, so no locking is needed.
+    // The fragments are appended in chunk order to keep the output the same as the serial path.
+    int chunks = (poly_count + ParallelPolyChunk - 1) / ParallelPolyChunk;
+    if ((int)m_fragments.size() < chunks)
+        m_fragments.resize(chunks);
+
+    for_each_chunk(parallel, poly_count, ParallelPolyChunk, [&](int begin, int end, int) {
+        auto &fragment = m_fragments[begin / ParallelPolyChunk];
+        fragment.clear();
+
+        camera_trans_to_renderlist(object, vp, rc, begin, end, fragment);
+    });
+
+    for (int i = 0; i < chunks; i++)
+        render_list.insert(render_list.end(), m_fragments[i].begin(), m_fragments[i].end());
+}
+
+static void mark_referenced_vertices(const RenderObject &object, std::vector<uint8_t> &vertex_refs) {
+    vertex_refs.assign(object.vertex_count, 0);
+
+    if (!(object.state & ObjectStateActive) || !(object.state & ObjectStateVisible))
+        return;
+
+    for (int i = 0; i < object.poly_count; i++) {
+        auto &poly = object.polygons[i];
+
+        if (!(object.poly_states[i] & PolyStateActive) || object.poly_states[i] & PolyStateBackface)
+            continue;
+
+        vertex_refs[poly.vert[0]] = 1;
+        vertex_refs[poly.vert[1]] = 1;
+        vertex_refs[poly.vert[2]] = 1;
+    }
+}
+
+static void world_transform_vertices(RenderObject &object, const uint8_t *vertex_refs,
+        int vertex_start, int vertex_end, CoordSelect coord_select)
+{
     Matrix4x4 mat_rot = object.transform.get_rotation_matrix();
 
     if (coord_select == CoordSelect::Local_To_Trans) {
-        for (int i = 0; i < object.vertex_count; i++) {
+        for (int i = vertex_start; i < vertex_end; i++) {
+            if (!vertex_refs[i])
+                continue;
+
             object.transformed_vertices[i].v = mat_rot.transform(object.local_vertices[i].v);
             object.transformed_vertices[i].n = mat_rot.transform(object.local_vertices[i].n);
 
@@ -65,7 +279,10 @@ void world_transform_object(RenderObject &object, CoordSelect coord_select) {
             object.transformed_vertices[i].v.z *= object.transform.scale.z;
         }
     } else if (coord_select == CoordSelect::Trans_Only) {
-        for (int i = 0; i < object.vertex_count; i++) {
+        for (int i = vertex_start; i < vertex_end; i++) {
+            if (!vertex_refs[i])
+                continue;
+
             object.transformed_vertices[i].v = mat_rot.transform(object.transformed_vertices[i].v);
 
             object.transformed_vertices[i].v = object.transformed_vertices[i].v + object.transform.pos;
@@ -77,24 +294,89 @@ void world_transform_object(RenderObject &object, CoordSelect coord_select) {
     }
 }
 
+void world_transform_object(RenderObject &object, CoordSelect coord_select) {
+    if (!(object.state & ObjectStateActive) || !(object.state & ObjectStateVisible))
+        return;
+
+    // only the vertices that are referenced by front facing polygons are transformed
+    static thread_local std::vector<uint8_t> vertex_refs;
+    mark_referenced_vertices(object, vertex_refs);
+
+    world_transform_vertices(object, vertex_refs.data(), 0, object.vertex_count, coord_select);
+}
+
+void select_lod_object(RenderObject &object, const Matrix4x4 &vp, const RenderContext &context) {
+    int num_lods = object.lods.size();
+    if (num_lods < 2)
+        return;
+
+    // same metric as the mip level selection, measured at the origin of the object
+    auto &trans = object.transform;
+    auto center = vp.transform(V4D(trans.pos.x * trans.scale.x, trans.pos.y * trans.scale.y, trans.pos.z * trans.scale.z));
+
+    int lod = (num_lods * center.z) / context.mip_z_dist;
+    if (lod > num_lods - 1) lod = num_lods - 1;
+    if (lod < 0) lod = 0;
+
+    object.polygons = object.lods[lod].polygons;
+    object.poly_count = object.lods[lod].poly_count;
+}
+
 void backface_removal_object(RenderObject& object, const Camera &camera) {
-    for (auto &poly : object.polygons) {
-        auto line1 = object.transformed_vertices[poly.vert[0]].v
-            - object.transformed_vertices[poly.vert[1]].v;
+    backface_removal_object(object, camera, 0, object.poly_count);
+}
 
-        auto line2 = object.transformed_vertices[poly.vert[0]].v
-            - object.transformed_vertices[poly.vert[2]].v;
+void backface_removal_object(RenderObject& object, const Camera &camera, int poly_start, int poly_end) {
+    if (!(object.state & ObjectStateActive) || !(object.state & ObjectStateVisible))
+        return;
 
-        auto camera_ray =  camera.m_transform.pos - object.transformed_vertices[poly.vert[0]].v;
-        poly.normal = line1.cross(line2);
+    // Bring the camera into the local space of the object, which is the inverse of
+    // world_transform_object: v_local = R^-1 * (v_world / scale - pos)
+    Matrix4x4 mat_rot_inv;
+    if (!object.transform.get_rotation_matrix().inverse(mat_rot_inv)) {
+        for (int i = poly_start; i < poly_end; i++)
+            object.poly_states[i] = object.polygons[i].state;
+
+        return;
+    }
+
+    auto &cam_pos = camera.m_transform.pos;
+    auto &trans = object.transform;
+
+    auto camera_local = mat_rot_inv.transform(V4D(
+                cam_pos.x / trans.scale.x - trans.pos.x,
+                cam_pos.y / trans.scale.y - trans.pos.y,
+                cam_pos.z / trans.scale.z - trans.pos.z));
+
+    bool multi_frame = object.attributes & ObjectAttributeMultiFrame;
+
+    for (int i = poly_start; i < poly_end; i++) {
+        auto &poly = object.polygons[i];
+        auto &v0 = object.local_vertices[poly.vert[0]].v;
+
+        // the precomputed normals only hold for the first frame of animated meshes
+        V4D normal = poly.normal;
+        if (multi_frame) {
+            auto line1 = v0 - object.local_vertices[poly.vert[1]].v;
+            auto line2 = v0 - object.local_vertices[poly.vert[2]].v;
+
+            normal = line1.cross(line2);
+        }
+
+        auto camera_ray = camera_local - v0;
+
+        // the mesh is shared, so the outcome goes into the poly states of the instance
+        uint16_t state = poly.state;
 
         if (poly.state & PolyAttributeTwoSided) {
-            if (poly.normal.dot(camera_ray) < 0.0f) {
-                poly.state |= PolyStateBackface;
-            } else if(poly.state & PolyStateBackface) {
-                poly.state ^= PolyStateBackface;
+            if (normal.dot(camera_ray) < 0.0f) {
+                state |= PolyStateBackface;
+            } else if(state & PolyStateBackface) {
+                state ^= PolyStateBackface;
             }
         }
+
+        object.poly_states[i] = state;
     }
 }
 
@@ -294,18 +576,30 @@ void camera_transform_lights(const Matrix4x4 &vp) {
 }
 
 void light_renderlist(RenderContext &context) {
-    for (auto &poly : context.render_list) {
-        if (poly.state & PolyStateClipped) {
+    light_renderlist(context, 0, context.render_list.size());
+}
+
+void light_renderlist(RenderContext &context, int poly_start, int poly_end) {
+    for (int i = poly_start; i < poly_end; i++) {
+        auto &poly = context.render_list[i];
+
+        if (poly.state & PolyStateClipped || poly.state & PolyStateLit) {
             continue;
         }
 
-        gourad_intensity_light_polygon(poly, g_lights, num_lights);
-        // flat_light_polygon(poly, g_lights, num_lights);
+        gourad_intensity_light_polygon(poly, g_lights.data());
+        // flat_light_polygon(poly, g_lights.data());
     }
 }
 
 void perspective_screen_transform_renderlist(const Camera &camera, RenderContext &context) {
-    for (auto &poly : context.render_list) {
+    perspective_screen_transform_renderlist(camera, context, 0, context.render_list.size());
+}
+
+void perspective_screen_transform_renderlist(const Camera &camera, RenderContext &context, int poly_start, int poly_end) {
+    for (int i = poly_start; i < poly_end; i++) {
+        auto &poly = context.render_list[i];
+
         if (poly.state & PolyStateClipped) {
             continue;
         }
@@ -325,26 +619,37 @@ void perspective_screen_transform_renderlist(const Camera &camera, RenderContext
 }
 
 void camera_trans_to_renderlist(RenderObject &object, const Matrix4x4 &vp, RenderContext &context) {
+    camera_trans_to_renderlist(object, vp, context, 0, object.poly_count, context.render_list);
+}
+
+void camera_trans_to_renderlist(RenderObject &object, const Matrix4x4 &vp, const RenderContext &context,
+        int poly_start, int poly_end, std::vector<RenderListPoly> &render_list)
+{
    if (!(object.state & ObjectStateActive) ||
            object.state & ObjectStateCulled ||
            !(object.state & ObjectStateVisible)) {
         return;
    }
 
-   for (auto current_poly : object.polygons) {
-        if (!(current_poly.state & PolyStateActive) ||
-                current_poly.state & PolyStateBackface) {
+   Matrix4x4 mat_rot = object.transform.get_rotation_matrix();
+
+   for (int i = poly_start; i < poly_end; i++) {
+        const auto &current_poly = object.polygons[i];
+        auto poly_state = object.poly_states[i];
+
+        if (!(poly_state & PolyStateActive) ||
+                poly_state & PolyStateBackface) {
             continue;
         }
 
         RenderListPoly render_poly = {
-            .state = current_poly.state,
+            .state = poly_state,
             .attributes = current_poly.attributes,
             .color = current_poly.color,
             .texture = current_poly.texture,
             .mati = current_poly.mati,
             .n_length = current_poly.n_length,
-            .normal = current_poly.normal.normalized(),
+            .normal = mat_rot.transform(current_poly.normal).normalized(),
             .alpha = object.alpha,
             .verts = {
                 object.local_vertices[current_poly.vert[0]],
@@ -356,11 +661,29 @@ void camera_trans_to_renderlist(RenderObject &object, const Matrix4x4 &vp, Rende
                 object.transformed_vertices[current_poly.vert[1]],
                 object.transformed_vertices[current_poly.vert[2]],
             },
+            .light_list = object.light_list.data(),
+            .light_count = (int)object.light_list.size(),
         };
 
-        render_poly.trans_verts[0].i = current_poly.vertices[0].i;
-        render_poly.trans_verts[1].i = current_poly.vertices[1].i;
-        render_poly.trans_verts[2].i = current_poly.vertices[2].i;
+        if (object.state & ObjectStateLit) {
+            // gather the intensities of the vertex lighting stage
+            render_poly.trans_verts[0].i = object.vertex_intensities[current_poly.vert[0]];
+            render_poly.trans_verts[1].i = object.vertex_intensities[current_poly.vert[1]];
+            render_poly.trans_verts[2].i = object.vertex_intensities[current_poly.vert[2]];
+
+            render_poly.state |= PolyStateLit;
+        } else if (!object.baked_intensities.empty()) {
+            render_poly.trans_verts[0].i = std::min(1.0f, object.baked_intensities[current_poly.vert[0]]);
+            render_poly.trans_verts[1].i = std::min(1.0f, object.baked_intensities[current_poly.vert[1]]);
+            render_poly.trans_verts[2].i = std::min(1.0f, object.baked_intensities[current_poly.vert[2]]);
+
+            render_poly.attributes |= PolyAttributeBakedLighting;
+            render_poly.state |= PolyStateLit;
+        } else {
+            render_poly.trans_verts[0].i = current_poly.vertices[0].i;
+            render_poly.trans_verts[1].i = current_poly.vertices[1].i;
+            render_poly.trans_verts[2].i = current_poly.vertices[2].i;
+        }
 
         // TODO optimize
         render_poly.trans_verts[0].t = current_poly.text_coords[current_poly.text[0]];
@@ -379,7 +702,7 @@ void camera_trans_to_renderlist(RenderObject &object, const Matrix4x4 &vp, Rende
         }
 
 
-        context.render_list.push_back(render_poly);
+        render_list.push_back(render_poly);
 
    }
 }
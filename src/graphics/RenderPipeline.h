@@ -8,6 +8,8 @@
 #include "Rasterizer.h"
 #include "RenderObject.h"
 #include "Lighting.h"
+#include "ScratchPool.h"
+#include "../core/JobSystem.h"
 
 namespace Graphics {
 
@@ -21,28 +23,70 @@ constexpr void camera_transform(const Matrix4x4 &vp, RenderListPoly &list_poly)
     list_poly.trans_verts[2].v = vp.transform(list_poly.trans_verts[2].v);
 }
 
+/*
+ * The object stages below work on the scratch of the instance, so transformed_vertices and
+ * poly_states have to point to buffers of the right size. RenderPipeline takes care of that.
+ */
 void world_transform_object(RenderObject &object, CoordSelect coord_select = CoordSelect::Local_To_Trans);
 
 void camera_trans_to_renderlist(RenderObject &object, const Matrix4x4 &vp, RenderContext &context);
 
+/* Appends the polygons [poly_start, poly_end) of the object to render_list instead of the context's list */
+void camera_trans_to_renderlist(RenderObject &object, const Matrix4x4 &vp, const RenderContext &context,
+        int poly_start, int poly_end, std::vector<RenderListPoly> &render_list);
+
 void camera_transform_lights(const Matrix4x4 &vp);
 
 void light_renderlist(RenderContext &context);
+void light_renderlist(RenderContext &context, int poly_start, int poly_end);
+
+/*
+ * Points the polygons of the object to a level of detail picked by the distance of the
+ * object, the levels are spread over mip_z_dist like the mip levels.
+ */
+void select_lod_object(RenderObject &object, const Matrix4x4 &vp, const RenderContext &context);
 
 void backface_removal_object(RenderObject& object, const Camera &camera);
+void backface_removal_object(RenderObject& object, const Camera &camera, int poly_start, int poly_end);
 
 void frustrum_clip_renderlist(const Camera &camera, RenderContext &context);
 
 void perspective_screen_transform_renderlist(const Camera &camera, RenderContext &context);
+void perspective_screen_transform_renderlist(const Camera &camera, RenderContext &context, int poly_start, int poly_end);
 
 void draw_renderlist(RenderContext &context);
 
 class RenderPipeline {
 public:
-    RenderPipeline(Renderer *renderer);
-    void render_objects(const Camera &camera, std::vector<RenderObject> renderables, RenderContext &context);
+    RenderPipeline(Renderer *renderer, Core::JobSystem *job_system);
+    void render_objects(const Camera &camera, std::vector<RenderObject> &renderables, RenderContext &context);
 private:
     Renderer* p_renderer = nullptr;
+
+    Core::JobSystem *p_job_system = nullptr;
+
+    // objects [begin, end) transformed by one job, large objects are alone and split into chunks
+    struct ObjectBatch {
+        int begin, end;
+        bool large;
+    };
+
+    // scratch data kept between frames to avoid reallocating
+    std::vector<uint8_t> m_vertex_refs;
+    std::vector<std::vector<RenderListPoly>> m_fragments;
+
+    std::vector<ObjectBatch> m_batches;
+    std::vector<std::vector<RenderListPoly>> m_batch_lists;
+
+    ScratchPool m_scratch_pool;
+
+    void for_each_chunk(bool parallel, int count, int chunk_size, const Core::JobSystem::RangeFn &fn);
+    void transform_objects_parallel(const Camera &camera, const Matrix4x4 &vp, std::vector<RenderObject> &renderables,
+            RenderContext &rc);
+    void transform_object(RenderObject &object, const Camera &camera, const Matrix4x4 &vp, RenderContext &rc, bool parallel,
+            std::vector<uint8_t> &vertex_refs, std::vector<RenderListPoly> &render_list);
+    void transform_instance(RenderObject &object, const Camera &camera, const Matrix4x4 &vp, RenderContext &rc, bool parallel,
+            std::vector<uint8_t> &vertex_refs, std::vector<RenderListPoly> &render_list);
 };
 
 }
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
 
 #include "../core/Window.h"
 #include "Renderer.h"
@@ -13,6 +14,9 @@ Renderer::Renderer() {
     m_width = p_window->get_width();
     m_height = p_window->get_height();
 
+    m_render_width = m_width;
+    m_render_height = m_height;
+
     create_framebuffer();
 
     p_screen_bitmap = p_window->get_screen_bitmap();
@@ -34,6 +38,9 @@ void Renderer::on_event(const WindowEvent &event) {
         m_width = event.body.expose_event.width;
         m_height = event.body.expose_event.height;
 
+        m_render_width = m_width;
+        m_render_height = m_height;
+
         delete[] p_framebuffer;
 
         create_framebuffer();
@@ -45,25 +52,39 @@ void Renderer::create_framebuffer() {
     std::fill(p_framebuffer, p_framebuffer + m_width * m_height, Pixel {.value = 0x00000000});
 }
 
-bool Renderer::render_framebuffer() {
+bool Renderer::render_framebuffer(HudLayer *overlay, const RenderContext *rc) {
     while (!p_window->ready_for_render) {
         // block untill drawing is complete
     }
 
-    for (int y_out = 0; y_out < m_height; y_out++) {
-        for (int x_out = 0; x_out < m_width; x_out++) {
-            auto value = p_framebuffer[m_width * y_out + x_out];
-		    *(p_screen_bitmap->buffer + m_width * y_out + x_out) = value.value;
-        }
-    }
+    InterlacedFrame interlaced;
+    bool is_interlaced = rc != nullptr && rc->draw_field;
+
+    if (is_interlaced)
+        interlaced = InterlacedFrame { rc->inv_z_buffer, rc->interlace_field };
+
+    m_present_pass.present(p_framebuffer, m_render_width, m_render_height,
+            p_screen_bitmap->buffer, m_width, m_height, overlay, p_app->get_job_system(),
+            is_interlaced ? &interlaced : nullptr);
 
     p_window->render_screen();
 
     return true;
 }
 
+void Renderer::set_color_grading(float gamma, const ColorLut *lut) {
+    m_present_pass.set_grading(gamma, lut);
+}
+
+void Renderer::set_render_resolution(int width, int height, UpscaleFilter filter) {
+    m_render_width = std::clamp(width, 1, m_width);
+    m_render_height = std::clamp(height, 1, m_height);
+
+    m_present_pass.set_upscale_filter(filter);
+}
+
 void Renderer::draw_line(const Point &p1, const Point &p2, const Color &color) {
-    if (p1.x > m_width || p1.y > m_height || p2.x > m_width || p2.y > m_height) {
+    if (p1.x > m_render_width || p1.y > m_render_height || p2.x > m_render_width || p2.y > m_render_height) {
         return;
     }
 
@@ -73,7 +94,7 @@ void Renderer::draw_line(const Point &p1, const Point &p2, const Color &color) {
     u_int32_t p_code = color.to_uint32();
 
     if (dx == 0 && dy == 0) {
-        p_framebuffer[m_width * p1.y + p1.x].value = p_code;
+        p_framebuffer[m_render_width * p1.y + p1.x].value = p_code;
     }
 
     if (dx > dy) {
@@ -90,7 +111,7 @@ void Renderer::draw_line(const Point &p1, const Point &p2, const Color &color) {
         float slope = (float) dy / (float) dx;
         for (auto x = xmin; x <= xmax; x++) {
             int y = std::floor(p1.y + ((x - p1.x) * slope));
-            (*(p_framebuffer + ((m_width * y) + x))).value = p_code;
+            (*(p_framebuffer + ((m_render_width * y) + x))).value = p_code;
         }
     } else {
         int ymin, ymax;
@@ -106,7 +127,7 @@ void Renderer::draw_line(const Point &p1, const Point &p2, const Color &color) {
         float slope = (float) dx / (float) dy;
         for (auto y = ymin; y <= ymax; y++) {
             int x = std::floor(p1.x + ((y - p1.y) * slope));
-            (*(p_framebuffer + ((m_width * y) + x))).value = p_code;
+            (*(p_framebuffer + ((m_render_width * y) + x))).value = p_code;
         }
     }
 }
@@ -116,73 +137,94 @@ void Renderer::clear_screen() {
         .value = 0x00000000
     };
 
-    std::fill(p_framebuffer, p_framebuffer + m_width * m_height, value);
+    std::fill(p_framebuffer, p_framebuffer + m_render_width * m_render_height, value);
+}
+
+void Renderer::clear_field(int field) {
+    for (int y = field; y < m_render_height; y += 2)
+        std::fill_n(p_framebuffer + m_render_width * y, m_render_width, Pixel {.value = 0x00000000});
 }
 
 void Renderer::set_frame_pixel(int x_pos, int y_pos, uint32_t value) {
-    p_framebuffer[m_width * y_pos + x_pos].value = value;
+    p_framebuffer[m_render_width * y_pos + x_pos].value = value;
 }
 
 void Renderer::set_frame_pixel(int x_pos, int y_pos, const Pixel &value) {
-    p_framebuffer[m_width * y_pos + x_pos] = value;
+    p_framebuffer[m_render_width * y_pos + x_pos] = value;
 }
 
 inline Pixel Renderer::get_pixel(int x_pos, int y_pos) {
-    return p_framebuffer[m_width * y_pos + x_pos];
+    return p_framebuffer[m_render_width * y_pos + x_pos];
 }
 
 
 void Renderer::render_texture(const Texture &texture, const Rect &src, const Rect &dest) {
-    if(dest.x_pos >= 0 && dest.width + dest.x_pos <= m_width
-            && dest.y_pos >= 0 && dest.height + dest.y_pos <= m_height)
-    {
-        float x_step = (float)src.width / (float)dest.width;
-        float y_step = (float)src.height / (float)dest.height;
-
-        float y = 0;
-        uint32_t a, r, g, b;
-
-        for (int y_out = 0; y_out < dest.height; y_out++) {
-            float x = 0;
-            for (int x_out = 0; x_out < dest.width; x_out++) {
-                auto pixel = texture.get_pixel(x + src.x_pos, y + src.y_pos);
-                pixel.rgba565_from_16bit(r, g, b, a);
-
-                if (a > 0) {
-                    p_framebuffer[m_width * (y_out + dest.y_pos) + (x_out + dest.x_pos)].value =
-                        rgba_bit((r << 3), (g << 2), (b << 3), a);
-                }
-
-                x += x_step;
-            }
-            y += y_step;
+    if (dest.width <= 0 || dest.height <= 0)
+        return;
+
+    int x_begin = std::max(0, dest.x_pos);
+    int y_begin = std::max(0, dest.y_pos);
+    int x_end = std::min(m_render_width, dest.x_pos + dest.width);
+    int y_end = std::min(m_render_height, dest.y_pos + dest.height);
+
+    // 16.16 fixed point steps through the source
+    int x_step = (src.width << 16) / dest.width;
+    int y_step = (src.height << 16) / dest.height;
+
+    auto pixels = texture.get_pixels();
+    int v = (y_begin - dest.y_pos) * y_step;
+
+    for (int y_out = y_begin; y_out < y_end; y_out++, v += y_step) {
+        auto src_row = pixels + texture.width * (src.y_pos + (v >> 16)) + src.x_pos;
+        auto dest_row = p_framebuffer + m_render_width * y_out;
+
+        int u = (x_begin - dest.x_pos) * x_step;
+
+        for (int x_out = x_begin; x_out < x_end; x_out++, u += x_step) {
+            A565Color pixel = src_row[u >> 16];
+
+            if ((pixel.value >> 24) > 0)
+                dest_row[x_out].value = pixel.rgba_bit();
         }
     }
 }
 
-void Renderer::render_text(std::string text, const TTFFont &font, const Point &point) {
-    Rect src;
-    src.x_pos = 0;
-    src.y_pos = 0;
+void Renderer::blit_texture(const Texture &texture, const Rect &src, int x_pos, int y_pos) {
+    // clip against the framebuffer, the source never gets scaled
+    int x_begin = std::max(0, -x_pos);
+    int y_begin = std::max(0, -y_pos);
+    int x_end = std::min(src.width, m_render_width - x_pos);
+    int y_end = std::min(src.height, m_render_height - y_pos);
 
-    int dest_x_pos = point.x;
+    auto pixels = texture.get_pixels();
 
-    for (auto c : text) {
-        auto glyph = font.get_glyph(c);
-        src.width = glyph.width;
-        src.height = glyph.height;
+    for (int y = y_begin; y < y_end; y++) {
+        auto src_row = pixels + texture.width * (src.y_pos + y) + src.x_pos;
+        auto dest_row = p_framebuffer + m_render_width * (y_pos + y) + x_pos;
 
-        // fonts are rendered from top to bottom, so we need to offset smaller glyphs
-        int render_from = font.get_font_size() - src.height;
-        Rect dest = src;
-        dest.x_pos = dest_x_pos;
-        dest.y_pos = point.y + render_from;
-        dest.width = glyph.width;
-        dest.height = glyph.height;
+        for (int x = x_begin; x < x_end; x++) {
+            A565Color pixel = src_row[x];
 
-        render_texture(glyph.texture, src, dest);
-        dest_x_pos += glyph.advance;
+            if ((pixel.value >> 24) > 0)
+                dest_row[x].value = pixel.rgba_bit();
+        }
     }
 }
 
+void Renderer::render_sprites(SpriteBatch &batch) {
+    batch.flush(get_blit_target());
+}
+
+void Renderer::render_hud(HudLayer &hud) {
+    hud.composite(get_blit_target());
+}
+
+void Renderer::render_text(const std::string &text, const TTFFont &font, const Point &point) {
+    auto &run = font.layout_text(text);
+    auto &atlas = font.get_atlas();
+
+    for (auto &quad : run.quads)
+        blit_texture(atlas, quad.src, point.x + quad.x_offset, point.y + quad.y_offset);
+}
+
 }
@@ -5,22 +5,15 @@
 #include "../core/Application.h"
 #include "Texture.h"
 #include "Font.h"
+#include "Blitter.h"
+#include "HudLayer.h"
+#include "PresentPass.h"
 
 #include <memory>
 
 namespace Graphics {
 using Math::Point2D;
 
-constexpr void pixel_blend(Pixel &pixel, const Pixel &other) {
-    float u_alpha = (float) pixel.alpha / (float) 0xFF;
-
-    pixel.blue = pixel.blue * u_alpha + other.blue * (1.0f - u_alpha);
-    pixel.red =  pixel.red * u_alpha + other.red * (1.0f - u_alpha);
-    pixel.green = pixel.green * u_alpha + other.green * (1.0f - u_alpha);
-    pixel.alpha = pixel.alpha * u_alpha + other.alpha * (1.0f - u_alpha);
-}
-
-
 class Renderer : EventObserver<WindowEvent> {
 public:
     Renderer();
@@ -29,9 +22,25 @@ public:
     void set_color(const Color &color);
     void draw_line(const Point &p1, const Point &p2, const Color &color);
     void clear_screen();
-    bool render_framebuffer();
+    void clear_field(int field);
+    /*
+     * Grades the frame, blends the overlay and writes the result to the screen in one pass. When the
+     * render context only drew a field, the rows of the other field are rebuilt on the way.
+     */
+    bool render_framebuffer(HudLayer *overlay = nullptr, const RenderContext *rc = nullptr);
+    void set_color_grading(float gamma, const ColorLut *lut = nullptr);
+
+    /*
+     * The scene and everything drawn into the framebuffer use the top left width * height pixels,
+     * render_framebuffer scales them up to the window. Resizing the window resets it.
+     */
+    void set_render_resolution(int width, int height, UpscaleFilter filter = UpscaleFilter::Bilinear);
     void render_texture(const Texture &texture, const Rect &src, const Rect &dest);
-    void render_text(std::string text, const TTFFont &font, const Point &point);
+    // copies the src rect 1:1 to x_pos, y_pos, pixels without alpha are skipped
+    void blit_texture(const Texture &texture, const Rect &src, int x_pos, int y_pos);
+    void render_text(const std::string &text, const TTFFont &font, const Point &point);
+    void render_sprites(SpriteBatch &batch);
+    void render_hud(HudLayer &hud);
     void on_event(const WindowEvent &event) override;
 
     void set_frame_pixel(int x_pos, int y_pos, uint32_t value);
@@ -41,8 +50,16 @@ public:
         return p_framebuffer;
     }
 
+    BlitTarget get_blit_target() {
+        return BlitTarget { p_framebuffer, m_render_width, m_render_height };
+    }
+
     int m_height;
     int m_width;
+
+    // part of the framebuffer that is drawn into, smaller than the window with dynamic resolution
+    int m_render_width;
+    int m_render_height;
 private:
     GWindow *p_window = nullptr;
 
@@ -51,6 +68,8 @@ private:
     std::shared_ptr<Application> p_app {nullptr};
     Pixel* p_framebuffer = nullptr;
 
+    PresentPass m_present_pass;
+
     void create_framebuffer();
     Pixel get_pixel(int x_pos, int y_pos);
 };
@@ -0,0 +1,36 @@
+#include "ScratchPool.h"
+
+namespace Graphics {
+
+InstanceScratch* ScratchPool::acquire(int vertex_count, int poly_count) {
+    InstanceScratch *scratch;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_free.empty()) {
+            m_scratches.push_back(std::make_unique<InstanceScratch>());
+            scratch = m_scratches.back().get();
+        } else {
+            scratch = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    // buffers only grow, so after the first frames this doesn't allocate anymore
+    if ((int)scratch->transformed_vertices.size() < vertex_count)
+        scratch->transformed_vertices.resize(vertex_count);
+
+    if ((int)scratch->poly_states.size() < poly_count)
+        scratch->poly_states.resize(poly_count);
+
+    return scratch;
+}
+
+void ScratchPool::release(InstanceScratch *scratch) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_free.push_back(scratch);
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <memory>
+
+#include "RenderObject.h"
+
+namespace Graphics {
+
+/* per frame working memory of one instance, only needed while the instance is transformed */
+struct InstanceScratch {
+    std::vector<Vertex4D> transformed_vertices;
+    std::vector<uint16_t> poly_states;
+};
+
+/*
+ * Hands out scratch buffers to instances and takes them back once the instance is in the
+ * render list. Buffers are recycled, so a scene only needs as many of them as there are
+ * instances being transformed at the same time, not one per instance.
+ */
+class ScratchPool {
+public:
+    ScratchPool() = default;
+
+    ScratchPool(const ScratchPool &other) = delete;
+    ScratchPool& operator=(const ScratchPool &other) = delete;
+
+    /* the returned buffers hold at least vertex_count vertices and poly_count poly states */
+    InstanceScratch* acquire(int vertex_count, int poly_count);
+    void release(InstanceScratch *scratch);
+private:
+    std::mutex m_mutex;
+
+    std::vector<std::unique_ptr<InstanceScratch>> m_scratches;
+    std::vector<InstanceScratch*> m_free;
+};
+
+}
@@ -2,6 +2,10 @@
 #include "Core.h"
 #include <exception>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 Texture::Texture(const Texture &other) : pixels(nullptr),
@@ -17,6 +21,9 @@ Texture::Texture(const Texture &other) : pixels(nullptr),
 Texture::Texture(Texture &&other) noexcept : pixels(nullptr), width(other.width), height(other.height) {
     pixels = other.pixels;
     other.pixels = nullptr;
+
+    m_owns_pixels = other.m_owns_pixels;
+    m_pitch_shift = other.m_pitch_shift;
 }
 
 Texture::Texture(int width, int height, A565Color* data) {
@@ -31,6 +38,17 @@ Texture::Texture(int width, int height, A565Color*&& data) {
     set_pitch_shift();
 }
 
+Texture::Texture(int width, int height, const uint32_t *borrowed_pixels) {
+    // the texture never writes to its pixels, so read only memory is fine
+    pixels = const_cast<uint32_t*>(borrowed_pixels);
+    m_owns_pixels = false;
+
+    this->width = width;
+    this->height = height;
+
+    set_pitch_shift();
+}
+
 Texture& Texture::operator=(const Texture &other) {
     *this = Texture(other);
     return *this;
@@ -42,11 +60,15 @@ Texture& Texture::operator=(Texture &&other) noexcept {
     width = other.width;
     height = other.height;
 
+    m_owns_pixels = other.m_owns_pixels;
+    m_pitch_shift = other.m_pitch_shift;
+
    return *this;
 }
 
 Texture::~Texture() {
-    delete[] reinterpret_cast<char*>(pixels);
+    if (m_owns_pixels)
+        delete[] reinterpret_cast<char*>(pixels);
 }
 
 bool Texture::load_from_bmp(std::string path) {
@@ -57,6 +79,132 @@ bool Texture::load_from_bmp(std::string path) {
         return false;
     }
 
+    read_bmp(bmp_reader);
+
+    return true;
+}
+
+// one row of quarter_size from two converted rows, bit exact with the scalar filter
+static void quarter_row(const uint32_t *row0, const uint32_t *row1, uint32_t *dst, int new_width, float gamma) {
+    int x = 0;
+
+#if defined(__SSE2__)
+    const __m128i mask5 = _mm_set1_epi32(31);
+    const __m128i mask6 = _mm_set1_epi32(63);
+    const __m128 v_gamma = _mm_set1_ps(gamma);
+    const __m128 v_quarter = _mm_set1_ps(4.0f);
+    const __m128 v_half = _mm_set1_ps(0.5f);
+
+    for (; x + 4 <= new_width; x += 4) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2 + 4));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2 + 4));
+
+        // vertical sums of both channels for eight source columns
+        __m128 blue0 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_and_si128(a0, mask5), _mm_and_si128(b0, mask5)));
+        __m128 blue1 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_and_si128(a1, mask5), _mm_and_si128(b1, mask5)));
+        __m128 green0 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(a0, 5), mask6),
+                    _mm_and_si128(_mm_srli_epi32(b0, 5), mask6)));
+        __m128 green1 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(a1, 5), mask6),
+                    _mm_and_si128(_mm_srli_epi32(b1, 5), mask6)));
+
+        // then the pairs of columns, the sums are small enough to be exact in a float
+        __m128 blue = _mm_add_ps(_mm_shuffle_ps(blue0, blue1, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(blue0, blue1, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128 green = _mm_add_ps(_mm_shuffle_ps(green0, green1, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(green0, green1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        __m128i b_avg = _mm_cvttps_epi32(_mm_add_ps(v_half, _mm_div_ps(_mm_mul_ps(v_gamma, blue), v_quarter)));
+        __m128i g_avg = _mm_cvttps_epi32(_mm_add_ps(v_half, _mm_div_ps(_mm_mul_ps(v_gamma, green), v_quarter)));
+
+        // the values are small and positive, so the 16 bit minimum works on the 32 bit lanes
+        b_avg = _mm_min_epi16(b_avg, mask5);
+        g_avg = _mm_min_epi16(g_avg, mask6);
+
+        __m128i result = _mm_or_si128(_mm_or_si128(b_avg, _mm_slli_epi32(g_avg, 5)), _mm_slli_epi32(b_avg, 11));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), result);
+    }
+#endif
+
+    for (; x < new_width; x++) {
+        uint32_t r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3;
+
+        A565Color(row0[x * 2 + 0]).rgb565_from_16bit(r0, g0, b0);
+        A565Color(row0[x * 2 + 1]).rgb565_from_16bit(r1, g1, b1);
+        A565Color(row1[x * 2 + 0]).rgb565_from_16bit(r2, g2, b2);
+        A565Color(row1[x * 2 + 1]).rgb565_from_16bit(r3, g3, b3);
+
+        int g_avg = (int)(0.5f + gamma * (float)(g0 + g1 + g2 + g3) / 4.0f);
+        int b_avg = (int)(0.5f + gamma * (float)(b0 + b1 + b2 + b3) / 4.0f);
+
+        if (g_avg > 63) g_avg = 63;
+        if (b_avg > 31) b_avg = 31;
+
+        dst[x] = A565Color(0, g_avg << 2, b_avg << 3).value;
+    }
+}
+
+bool Texture::load_from_bmp(const char *data, size_t size, std::unique_ptr<Texture> *mip_level_1, float gamma) {
+    BmpInfo info;
+
+    // the reader fallback trusts the headers as well, so a broken bmp isn't handed to it
+    if (!read_bmp_info(data, size, info)) {
+        return false;
+    }
+
+    if (info.bits_per_pixel != 32) {
+        BmpReader bmp_reader;
+
+        if (!bmp_reader.open_memory(data, size)) {
+            return false;
+        }
+
+        read_bmp(bmp_reader);
+
+        return true;
+    }
+
+    width = info.width;
+    height = info.height;
+
+    set_pitch_shift();
+
+    pixels = new uint32_t[width * height];
+
+    // quarter_size addresses the rows by the pitch shift, only widths that have one give the same result
+    bool build_mip = mip_level_1 != nullptr && m_pitch_shift > 0 && (1 << m_pitch_shift) == width && height % 2 == 0;
+
+    int new_width = width / 2;
+    uint32_t *mip_pixels = build_mip ? new uint32_t[new_width * (height / 2)] : nullptr;
+
+    auto src = data + info.pix_array_offset;
+
+    for (int i = 0; i < height; i++) {
+        // the rows are stored bottom up, so the bitmap isn't inverted
+        int y = height - i - 1;
+        convert_bmp_row(src + (size_t)width * 4 * i, pixels + width * y, width);
+
+        // the second row of a pair is done, the pair is still in the cache
+        if (build_mip && y % 2 == 0)
+            quarter_row(pixels + width * y, pixels + width * (y + 1), mip_pixels + new_width * (y / 2), new_width, gamma);
+    }
+
+    if (build_mip) {
+        auto mip_texture = std::make_unique<Texture>();
+
+        mip_texture->width = new_width;
+        mip_texture->height = height / 2;
+        mip_texture->pixels = mip_pixels;
+        mip_texture->set_pitch_shift();
+
+        *mip_level_1 = std::move(mip_texture);
+    }
+
+    return true;
+}
+
+void Texture::read_bmp(BmpReader &bmp_reader) {
     size_t s {0};
     auto bitmap = std::unique_ptr<unsigned char>(nullptr);
     bmp_reader.read_to_buffer(bitmap);
@@ -71,8 +219,6 @@ bool Texture::load_from_bmp(std::string path) {
     set_pitch_shift();
 
     height = bmp_reader.get_height();
-
-    return true;
 }
 
 Texture Texture::from_section(Rect src) {
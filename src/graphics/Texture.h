@@ -22,6 +22,9 @@ public:
     Texture(int width, int height, A565Color* data);
     Texture(int width, int height, A565Color*&& data);
 
+    /* uses the pixels without copying or owning them, they have to outlive the texture */
+    Texture(int width, int height, const uint32_t *borrowed_pixels);
+
     Texture(const Texture &other);
     Texture(Texture &&other) noexcept;
 
@@ -32,12 +35,24 @@ public:
     Texture& operator=(Texture &&other) noexcept;
 
     bool load_from_bmp(std::string path);
+
+    /*
+     * Decodes a bmp in memory. 32 bit bitmaps are converted row by row straight into the pixels
+     * of the texture. When mip_level_1 is given and the size allows it, the first level of
+     * quarter_size(gamma) is built in the same pass, otherwise it stays empty.
+     */
+    bool load_from_bmp(const char *data, size_t size, std::unique_ptr<Texture> *mip_level_1 = nullptr,
+            float gamma = 1.01f);
     Texture from_section(Rect src);
 
     void set_data(int width, int height, A565Color* data);
 
     std::unique_ptr<Texture> quarter_size(float gamma);
 
+    const uint32_t* get_pixels() const {
+        return pixels;
+    }
+
     constexpr A565Color get_pixel(int x_pos, int y_pos) const {
         return pixels[width * y_pos + x_pos];
     };
@@ -52,7 +67,11 @@ private:
     int m_pitch_shift = 0;
     uint32_t *pixels = nullptr;
 
+    // false when the pixels belong to somebody else, e.g. a mapped texture container
+    bool m_owns_pixels = true;
+
     void set_pitch_shift();
+    void read_bmp(BmpReader &bmp_reader);
 };
 
 using MipTexturesList = std::vector<std::unique_ptr<Graphics::Texture>>;
@@ -1,6 +1,11 @@
 #include "BmpReader.h"
 #include "../graphics/RenderObject.h"
 #include <iostream>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 BmpReader::BmpReader() {}
 
@@ -13,12 +18,24 @@ bool BmpReader::open_file(string path) {
         return false;
     }
 
+    p_in = &m_ifs;
+
     read_header();
     read_dib_header();
 
     return true;
 };
 
+bool BmpReader::open_memory(const char *data, size_t size) {
+    p_memory = std::make_unique<MemoryStream>(data, size);
+    p_in = p_memory.get();
+
+    read_header();
+    read_dib_header();
+
+    return bool(*p_in);
+}
+
 size_t BmpReader::read_to_buffer(std::unique_ptr<unsigned char> &bitmap) {
     auto pixels_amt = m_dib_header.bitmap_size / (m_dib_header.bits_per_pixel >> 3);
     if (m_dib_header.bits_per_pixel == 32) {
@@ -29,16 +46,15 @@ size_t BmpReader::read_to_buffer(std::unique_ptr<unsigned char> &bitmap) {
         bitmap.reset(reinterpret_cast<unsigned char*>(raw));
     }
 
-    m_ifs.seekg(m_header.pix_array_offset, std::ios_base::beg);
+    p_in->seekg(m_header.pix_array_offset, std::ios_base::beg);
 
     for (int i = 0; i < m_dib_header.height; i++) {
         // reading the rows in inverse order, so that the bitmap of the image isn't inverted.
         uint32_t* row_ptr = row(m_dib_header.height - i - 1, reinterpret_cast<uint32_t*>(bitmap.get()));
-        m_ifs.read(reinterpret_cast<char*>(row_ptr), 4 * m_dib_header.width);
+        p_in->read(reinterpret_cast<char*>(row_ptr), 4 * m_dib_header.width);
 
         // TODO: add this in a derivative class?
-        for (int i = 0; i < m_dib_header.width; i++)
-            row_ptr[i] = Graphics::A565Color(row_ptr[i] >> 16, row_ptr[i] >> 8, row_ptr[i]).value;
+        convert_bmp_row(reinterpret_cast<const char*>(row_ptr), row_ptr, m_dib_header.width);
     }
 
     return m_dib_header.bitmap_size;
@@ -47,12 +63,12 @@ size_t BmpReader::read_to_buffer(std::unique_ptr<unsigned char> &bitmap) {
 void* BmpReader::read_file(string path) {
     auto bitmap = new uint32_t[m_dib_header.bitmap_size / (m_dib_header.bits_per_pixel / 8)];
 
-    m_ifs.seekg(m_header.pix_array_offset, std::ios_base::beg);
+    p_in->seekg(m_header.pix_array_offset, std::ios_base::beg);
 
     for (int i = 0; i < m_dib_header.height; i++) {
         // reading the rows in inverse order, so that the bitmap of the image isn't inverted.
         uint32_t* row_ptr = row(m_dib_header.height - i - 1, reinterpret_cast<uint32_t*>(bitmap));
-        m_ifs.read(reinterpret_cast<char*>(row_ptr), 4 * m_dib_header.width);
+        p_in->read(reinterpret_cast<char*>(row_ptr), 4 * m_dib_header.width);
     }
 
     return bitmap;
@@ -61,25 +77,71 @@ void* BmpReader::read_file(string path) {
 
 
 inline void BmpReader::read_header() {
-    m_ifs.seekg(0x02, std::ios_base::beg);
-    m_ifs.read(reinterpret_cast<char*>(&m_header.size), sizeof(m_header.size));
+    p_in->seekg(0x02, std::ios_base::beg);
+    p_in->read(reinterpret_cast<char*>(&m_header.size), sizeof(m_header.size));
 
-    m_ifs.seekg(0x0A, std::ios_base::beg);
-    m_ifs.read(reinterpret_cast<char*>(&m_header.pix_array_offset), sizeof(m_header.pix_array_offset));
+    p_in->seekg(0x0A, std::ios_base::beg);
+    p_in->read(reinterpret_cast<char*>(&m_header.pix_array_offset), sizeof(m_header.pix_array_offset));
 }
 
 inline void BmpReader::read_dib_header() {
-    m_ifs.seekg(0x12, std::ios_base::beg);
-    m_ifs.read(reinterpret_cast<char*>(&m_dib_header.width), sizeof(m_dib_header.width));
-    m_ifs.read(reinterpret_cast<char*>(&m_dib_header.height), sizeof(m_dib_header.height));
+    p_in->seekg(0x12, std::ios_base::beg);
+    p_in->read(reinterpret_cast<char*>(&m_dib_header.width), sizeof(m_dib_header.width));
+    p_in->read(reinterpret_cast<char*>(&m_dib_header.height), sizeof(m_dib_header.height));
 
-    m_ifs.seekg(0x1C, std::ios_base::beg);
-    m_ifs.read(reinterpret_cast<char*>(&m_dib_header.bits_per_pixel), sizeof(m_dib_header.bits_per_pixel));
+    p_in->seekg(0x1C, std::ios_base::beg);
+    p_in->read(reinterpret_cast<char*>(&m_dib_header.bits_per_pixel), sizeof(m_dib_header.bits_per_pixel));
 
-    m_ifs.seekg(0x22, std::ios_base::beg);
-    m_ifs.read(reinterpret_cast<char*>(&m_dib_header.bitmap_size), sizeof(m_dib_header.bitmap_size));
+    p_in->seekg(0x22, std::ios_base::beg);
+    p_in->read(reinterpret_cast<char*>(&m_dib_header.bitmap_size), sizeof(m_dib_header.bitmap_size));
 }
 
 uint32_t* BmpReader::row(int row, uint32_t* bitmap) {
     return &bitmap[m_dib_header.width * row];
 }
+
+bool read_bmp_info(const char *data, size_t size, BmpInfo &info) {
+    if (size < 0x22)
+        return false;
+
+    std::memcpy(&info.pix_array_offset, data + 0x0A, sizeof(info.pix_array_offset));
+    std::memcpy(&info.width, data + 0x12, sizeof(info.width));
+    std::memcpy(&info.height, data + 0x16, sizeof(info.height));
+    std::memcpy(&info.bits_per_pixel, data + 0x1C, sizeof(info.bits_per_pixel));
+
+    // negative heights of top down bitmaps end up above the limit as well
+    if (info.width == 0 || info.height == 0 || info.width > BmpMaxSide || info.height > BmpMaxSide
+            || info.bits_per_pixel > 32 || info.pix_array_offset > size)
+        return false;
+
+    size_t row_size = ((size_t)info.width * info.bits_per_pixel / 8 + 3) & ~(size_t)3;
+
+    return row_size * info.height <= size - info.pix_array_offset;
+}
+
+void convert_bmp_row(const char *src, uint32_t *dst, int width) {
+    int x = 0;
+
+#if defined(__SSE2__)
+    const __m128i mask5 = _mm_set1_epi32(31);
+    const __m128i mask6 = _mm_set1_epi32(63);
+
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+
+        // the blue channel ends up in both 5 bit fields, see A565Color(r, g, b)
+        __m128i b5 = _mm_and_si128(_mm_srli_epi32(pixels, 3), mask5);
+        __m128i g6 = _mm_and_si128(_mm_srli_epi32(pixels, 10), mask6);
+
+        __m128i result = _mm_or_si128(_mm_or_si128(b5, _mm_slli_epi32(g6, 5)), _mm_slli_epi32(b5, 11));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), result);
+    }
+#endif
+
+    for (; x < width; x++) {
+        uint32_t pixel;
+        std::memcpy(&pixel, src + x * 4, sizeof(pixel));
+
+        dst[x] = Graphics::A565Color(pixel >> 16, pixel >> 8, pixel).value;
+    }
+}
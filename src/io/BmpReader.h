@@ -4,13 +4,38 @@
 #include <fstream>
 #include <memory>
 
+#include "MemoryStream.h"
+
 using std::string;
 
+struct BmpInfo {
+    uint32_t width;
+    uint32_t height;
+    uint32_t pix_array_offset;
+    uint16_t bits_per_pixel;
+};
+
+// larger sides are rejected, so the sizes derived from them can't overflow
+static constexpr uint32_t BmpMaxSide = 1 << 15;
+
+/* reads the headers of a bmp in memory, false when the pixels don't fit in the data */
+bool read_bmp_info(const char *data, size_t size, BmpInfo &info);
+
+/*
+ * Converts a row of 32 bit bmp pixels to the texture format, the same way A565Color(r, g, b)
+ * does. Four pixels at a time with SSE2. The pixel array of a bmp is only 2 byte aligned, so
+ * src may have any alignment.
+ */
+void convert_bmp_row(const char *src, uint32_t *dst, int width);
+
 class BmpReader {
 public:
     BmpReader();
 
     bool open_file(string path);
+
+    /* reads from a bmp in memory, the data has to outlive the reader */
+    bool open_memory(const char *data, size_t size);
     size_t read_to_buffer(std::unique_ptr<unsigned char> &bitmap);
     void* read_file(string path);
 
@@ -42,6 +67,10 @@ private:
     };
 
     std::ifstream m_ifs;
+    std::unique_ptr<MemoryStream> p_memory;
+
+    // m_ifs or p_memory
+    std::istream *p_in = &m_ifs;
 
     inline void read_header();
     inline void read_dib_header();
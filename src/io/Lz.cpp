@@ -0,0 +1,160 @@
+#include <cstring>
+#include <cstdint>
+
+#include "Lz.h"
+
+static constexpr int HashBits = 14;
+
+// the last bytes of a block are always literals, so a match never reads past the end
+static constexpr int LastLiterals = 5;
+
+static uint32_t read32(const char *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+
+    return value;
+}
+
+static uint32_t hash32(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HashBits);
+}
+
+static void write_length(std::vector<char> &out, size_t length) {
+    while (length >= 255) {
+        out.push_back((char)255);
+        length -= 255;
+    }
+
+    out.push_back((char)length);
+}
+
+static void write_sequence(std::vector<char> &out, const char *literals, size_t num_literals,
+        size_t offset, size_t match_length)
+{
+    size_t match_code = match_length >= LzMinMatch ? match_length - LzMinMatch : 0;
+
+    uint8_t token = (num_literals < 15 ? num_literals : 15) << 4;
+    token |= match_code < 15 ? match_code : 15;
+
+    out.push_back((char)token);
+
+    if (num_literals >= 15)
+        write_length(out, num_literals - 15);
+
+    out.insert(out.end(), literals, literals + num_literals);
+
+    if (match_length == 0)
+        return;
+
+    out.push_back((char)(offset & 0xFF));
+    out.push_back((char)(offset >> 8));
+
+    if (match_code >= 15)
+        write_length(out, match_code - 15);
+}
+
+size_t lz_compress(const char *src, size_t size, std::vector<char> &out) {
+    size_t start = out.size();
+
+    std::vector<int64_t> table(1 << HashBits, -1);
+
+    size_t pos = 0;
+    size_t anchor = 0;
+
+    while (size >= LzMinMatch + LastLiterals && pos + LzMinMatch + LastLiterals <= size) {
+        uint32_t sequence = read32(src + pos);
+        uint32_t hash = hash32(sequence);
+
+        int64_t candidate = table[hash];
+        table[hash] = pos;
+
+        if (candidate < 0 || pos - candidate > LzMaxOffset || read32(src + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        size_t length = LzMinMatch;
+        size_t limit = size - LastLiterals;
+
+        while (pos + length < limit && src[candidate + length] == src[pos + length])
+            length++;
+
+        write_sequence(out, src + anchor, pos - anchor, pos - candidate, length);
+
+        pos += length;
+        anchor = pos;
+    }
+
+    write_sequence(out, src + anchor, size - anchor, 0, 0);
+
+    return out.size() - start;
+}
+
+static bool read_length(const uint8_t *&in, const uint8_t *end, size_t &length) {
+    uint8_t value;
+
+    do {
+        if (in >= end)
+            return false;
+
+        value = *in++;
+        length += value;
+    } while (value == 255);
+
+    return true;
+}
+
+bool lz_decompress(const char *src, size_t packed_size, char *dst, size_t size) {
+    auto in = reinterpret_cast<const uint8_t*>(src);
+    auto in_end = in + packed_size;
+
+    char *out = dst;
+    char *out_end = dst + size;
+
+    while (in < in_end) {
+        uint8_t token = *in++;
+
+        size_t num_literals = token >> 4;
+        if (num_literals == 15 && !read_length(in, in_end, num_literals))
+            return false;
+
+        if (num_literals > (size_t)(in_end - in) || num_literals > (size_t)(out_end - out))
+            return false;
+
+        std::memcpy(out, in, num_literals);
+        in += num_literals;
+        out += num_literals;
+
+        // the last sequence ends the block after its literals
+        if (in == in_end)
+            break;
+
+        if (in_end - in < 2)
+            return false;
+
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+
+        size_t length = token & 0x0F;
+        if (length == 15 && !read_length(in, in_end, length))
+            return false;
+
+        length += LzMinMatch;
+
+        if (offset == 0 || offset > (size_t)(out - dst) || length > (size_t)(out_end - out))
+            return false;
+
+        const char *match = out - offset;
+
+        if (offset >= length) {
+            std::memcpy(out, match, length);
+            out += length;
+        } else {
+            // overlapping matches repeat the last offset bytes
+            for (size_t i = 0; i < length; i++)
+                *out++ = match[i];
+        }
+    }
+
+    return out == out_end;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Byte oriented LZ77 block codec in the spirit of LZ4. A block is a list of sequences, every
+ * sequence is a token byte (literal length in the high nibble, match length - LzMinMatch in the
+ * low nibble), extra literal length bytes when the nibble is 15, the literals, a little endian
+ * 16 bit match offset and extra match length bytes. The last sequence only has literals.
+ * Decoding is a single pass of copies with no entropy stage, so it runs at memory speed.
+ */
+static constexpr int LzMinMatch = 4;
+static constexpr int LzMaxOffset = 65535;
+
+/* appends the compressed block to out and returns its size */
+size_t lz_compress(const char *src, size_t size, std::vector<char> &out);
+
+/* returns false when the block is malformed or doesn't decode to exactly size bytes */
+bool lz_decompress(const char *src, size_t packed_size, char *dst, size_t size);
@@ -2,8 +2,67 @@
 
 #include <sstream>
 #include <iostream>
+#include <cstring>
+
+bool read_map(const char *data, size_t size, MapView &view) {
+    if (size < sizeof(MapHeader))
+        return false;
+
+    auto header = reinterpret_cast<const MapHeader*>(data);
+
+    if (std::memcmp(header->magic, MapMagic, sizeof(MapMagic)) != 0 || header->version != MapVersion)
+        return false;
+
+    if (header->width < 0 || header->farth < 0)
+        return false;
+
+    size_t plane_size = (size_t)header->width * header->farth * sizeof(uint16_t);
+
+    if (header->heights_offset % MapAlignment != 0 || header->terrains_offset % MapAlignment != 0
+            || header->heights_offset + plane_size > size || header->terrains_offset + plane_size > size) {
+        std::cerr << "read_map() Error: planes out of bounds" << std::endl;
+        return false;
+    }
+
+    view.width = header->width;
+    view.farth = header->farth;
+    view.heights = reinterpret_cast<const uint16_t*>(data + header->heights_offset);
+    view.terrains = reinterpret_cast<const uint16_t*>(data + header->terrains_offset);
+
+    return true;
+}
 
 bool MapReader::read_file(string path, MapFile &file) {
+    MapView view;
+
+    if (!map_file(path, view))
+        return read_text_file(path, file);
+
+    file.width = view.width;
+    file.farth = view.farth;
+    file.ter_codes.resize(view.width * view.farth);
+
+    for (int i = 0; i < view.width * view.farth; i++)
+        file.ter_codes[i] = TerrainTile { view.terrains[i], view.heights[i] };
+
+    m_mapped_file.close();
+
+    return true;
+}
+
+bool MapReader::map_file(string path, MapView &view) {
+    if (!m_mapped_file.open(path))
+        return false;
+
+    if (!read_map(m_mapped_file.data(), m_mapped_file.size(), view)) {
+        m_mapped_file.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MapReader::read_text_file(string path, MapFile &file) {
     m_ifs = std::ifstream(path);
 
     if (!m_ifs.is_open()) {
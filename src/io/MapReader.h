@@ -1,10 +1,45 @@
+#pragma once
+
 #include <fstream>
 #include <vector>
 #include <string>
+#include <cstdint>
+
+#include "MappedFile.h"
 
 using std::string;
 using std::vector;
 
+/*
+ * Binary map. The header is followed by the height plane and the terrain code plane, each
+ * width * farth uint16_t in row order and starting at a multiple of MapAlignment from the
+ * start of the file, so both planes can be used straight from a memory mapping.
+ */
+static constexpr char MapMagic[4] = { 'M', 'A', 'P', '1' };
+static constexpr int MapVersion = 1;
+static constexpr int MapAlignment = 64;
+
+struct MapHeader {
+    char magic[4];
+    int32_t version;
+    int32_t width;
+    int32_t farth;
+
+    uint32_t heights_offset;
+    uint32_t terrains_offset;
+    uint32_t reserved[2];
+};
+
+struct MapView {
+    int width, farth;
+
+    const uint16_t *heights;
+    const uint16_t *terrains;
+};
+
+/* checks the header and that both planes lie within the data, nothing is copied */
+bool read_map(const char *data, size_t size, MapView &view);
+
 struct TerrainTile {
     unsigned short terrain;
     unsigned short height;
@@ -28,14 +63,20 @@ public:
 
     ~MapReader();
 
+    // reads binary and text maps
     bool read_file(string path, MapFile &file);
+
+    // binary maps only, the view points into the mapping and is valid while the reader lives
+    bool map_file(string path, MapView &view);
 private:
     std::ifstream m_ifs;
+    MappedFile m_mapped_file;
 
     enum class Section {
         Terrain,
         Texture,
     } m_cur_section;
 
+    bool read_text_file(string path, MapFile &file);
     void read_section(std::stringstream &ss, MapFile &file);
 };
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) {
+    p_data = std::exchange(other.p_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+}
+
+MappedFile& MappedFile::operator=(MappedFile &&other) {
+    if (this != &other) {
+        close();
+
+        p_data = std::exchange(other.p_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    return *this;
+}
+
+bool MappedFile::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "MappedFile::open() Error: file "
+            << path << " not found!" << std::endl;
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    p_data = static_cast<const char*>(data);
+    m_size = file_stat.st_size;
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (p_data != nullptr)
+        munmap(const_cast<char*>(p_data), m_size);
+
+    p_data = nullptr;
+    m_size = 0;
+}
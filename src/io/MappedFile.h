@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+ * Read only memory mapping of a whole file. The data stays valid as long as the object lives,
+ * pages are only read from disk when they are touched.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile& operator=(const MappedFile &other) = delete;
+
+    MappedFile(MappedFile &&other);
+    MappedFile& operator=(MappedFile &&other);
+
+    bool open(const std::string &path);
+    void close();
+
+    const char* data() const {
+        return p_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    bool is_open() const {
+        return p_data != nullptr;
+    }
+private:
+    const char *p_data = nullptr;
+    size_t m_size = 0;
+};
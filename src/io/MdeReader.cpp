@@ -1,7 +1,9 @@
 #include <iostream>
 #include <iterator>
+#include <cstring>
 
 #include "MdeReader.h"
+#include "MemoryStream.h"
 
 std::ofstream& operator<<(std::ofstream& out, const MdeHeader &header) {
     out.write((char*) &header.version, sizeof(header.version));
@@ -23,7 +25,7 @@ std::ofstream& operator<<(std::ofstream& out, const MdeHeader &header) {
     return out;
 }
 
-std::ifstream& operator>>(std::ifstream& in, const MdeHeader &header) {
+std::istream& operator>>(std::istream& in, const MdeHeader &header) {
     in.read((char*) &header.version, sizeof(header.version));
     in.read((char*) &header.skin_size, sizeof(header.skin_size));
     in.read((char*) &header.frame_size, sizeof(header.frame_size));
@@ -57,45 +59,217 @@ bool MdeReader::read_file(std::string path, MdeFile &result) {
         return false;
     }
 
-    MdeHeader header;
-    m_ifs >> header;
+    return read_stream(m_ifs, result);
+}
+
+bool MdeReader::read_memory(const char *data, size_t size, MdeFile &result) {
+    MemoryStream in(data, size);
+
+    return read_stream(in, result);
+}
+
+bool MdeReader::read_stream(std::istream &in, MdeFile &result) {
+    MdeHeader header {};
+    in >> header;
+
+    // the counts size the allocations below, a truncated header must not get that far
+    if (!in) {
+        std::cerr << "MdeReader::read_stream() Error: header could not be read" << std::endl;
+        return false;
+    }
 
     result.header = header;
 
     // Read the skins
-    m_ifs.seekg(header.offset_skins, std::ios_base::beg);
+    in.seekg(header.offset_skins, std::ios_base::beg);
 
     result.skins = std::unique_ptr<char[64]>(new char[header.num_skins][64]);
 
-    m_ifs.read(reinterpret_cast<char*>(result.skins.get()), sizeof(char) * 64 * header.num_skins);
+    in.read(reinterpret_cast<char*>(result.skins.get()), sizeof(char) * 64 * header.num_skins);
 
     // Read the vert data
-    m_ifs.seekg(header.offset_verts, std::ios_base::beg);
+    in.seekg(header.offset_verts, std::ios_base::beg);
 
     int verts_amount = header.num_verts * header.num_frames;
     result.verts = std::unique_ptr<MdeVert>(new MdeVert[verts_amount]);
 
-    m_ifs.read(reinterpret_cast<char*>(result.verts.get()), sizeof(MdeVert) * verts_amount);
+    in.read(reinterpret_cast<char*>(result.verts.get()), sizeof(MdeVert) * verts_amount);
 
     // Read the texture coordinates
-    m_ifs.seekg(header.offset_textcoords, std::ios_base::beg);
+    in.seekg(header.offset_textcoords, std::ios_base::beg);
     result.text_coords = std::unique_ptr<MdeTextCoord>(new MdeTextCoord[header.num_textcoords]);
 
-    m_ifs.read(reinterpret_cast<char*>(result.text_coords.get()), sizeof(MdeTextCoord) * header.num_textcoords);
+    in.read(reinterpret_cast<char*>(result.text_coords.get()), sizeof(MdeTextCoord) * header.num_textcoords);
 
     // Read polys data
-    m_ifs.seekg(header.offset_polys, std::ios_base::beg);
+    in.seekg(header.offset_polys, std::ios_base::beg);
 
     int polys_amount = header.num_polys * header.num_frames;
     result.polys = std::unique_ptr<MdePoly>(new MdePoly[polys_amount]);
 
-    m_ifs.read(reinterpret_cast<char*>(result.polys.get()), sizeof(MdePoly) * polys_amount);
+    in.read(reinterpret_cast<char*>(result.polys.get()), sizeof(MdePoly) * polys_amount);
 
     // Read frame data
-    m_ifs.seekg(header.offset_textcoords, std::ios_base::beg);
+    in.seekg(header.offset_textcoords, std::ios_base::beg);
     result.frames = std::unique_ptr<MdeFrame>(new MdeFrame[header.num_frames]);
 
-    m_ifs.read(reinterpret_cast<char*>(result.frames.get()), sizeof(MdeFrame) * header.num_frames);
+    in.read(reinterpret_cast<char*>(result.frames.get()), sizeof(MdeFrame) * header.num_frames);
+
+    // Read the levels of detail, older files end at offset_end
+    in.clear();
+    in.seekg(0, std::ios_base::end);
+    std::streamoff stream_size = in.tellg();
+    in.seekg(header.offset_end, std::ios_base::beg);
+
+    // the counts come from the file, none of them may reach past its end
+    auto remaining = [&in, stream_size]() -> std::streamoff {
+        return stream_size - in.tellg();
+    };
+
+    char tag[4];
+    if (in.read(tag, sizeof(tag)) && std::memcmp(tag, MdeLodsTag, sizeof(tag)) == 0) {
+        int num_lods = 0;
+        in.read(reinterpret_cast<char*>(&num_lods), sizeof(num_lods));
+
+        // every level starts with its count, so the rest of the stream bounds the amount
+        if (!in || num_lods < 0 || num_lods > remaining() / (std::streamoff)sizeof(int)) {
+            std::cerr << "MdeReader::read_stream() Error: invalid amount of levels of detail" << std::endl;
+            return false;
+        }
+
+        result.lods.resize(num_lods);
+
+        for (auto &lod : result.lods) {
+            int num_polys = 0;
+            in.read(reinterpret_cast<char*>(&num_polys), sizeof(num_polys));
+
+            // a level is a reduction of the full mesh
+            if (!in || num_polys < 0 || num_polys > header.num_polys
+                    || num_polys > remaining() / (std::streamoff)sizeof(MdePoly)) {
+                std::cerr << "MdeReader::read_stream() Error: invalid level of detail" << std::endl;
+                return false;
+            }
+
+            lod.resize(num_polys);
+            in.read(reinterpret_cast<char*>(lod.data()), sizeof(MdePoly) * num_polys);
+
+            if (!in) {
+                std::cerr << "MdeReader::read_stream() Error: level of detail is truncated" << std::endl;
+                return false;
+            }
+
+            // the loader indexes the vertices and texture coordinates of the mesh with them
+            for (const auto &poly : lod) {
+                for (int j = 0; j < 3; j++) {
+                    if (poly.v_index[j] >= header.num_verts
+                            || (header.num_textcoords > 0 && poly.t_index[j] >= header.num_textcoords)) {
+                        std::cerr << "MdeReader::read_stream() Error: level of detail index out of range" << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+int mde_version(const char *data, size_t size) {
+    if (size < sizeof(int32_t))
+        return 0;
+
+    int32_t version;
+    std::memcpy(&version, data, sizeof(version));
+
+    return version;
+}
+
+template<class T>
+static bool map_section(const char *data, size_t size, const MdeSection &section, size_t count, const T *&result) {
+    if (section.offset % MdeAlignment != 0 || count > size / sizeof(T) || section.size < count * sizeof(T)
+            || (size_t)section.offset + section.size > size)
+        return false;
+
+    result = reinterpret_cast<const T*>(data + section.offset);
+
+    return true;
+}
+
+bool read_mde_v2(const char *data, size_t size, MdeView &view) {
+    if (size < sizeof(MdeHeaderV2))
+        return false;
+
+    auto header = reinterpret_cast<const MdeHeaderV2*>(data);
+
+    if (header->version != MdeVersion2 || std::memcmp(header->magic, MdeMagic, sizeof(MdeMagic)) != 0) {
+        std::cerr << "read_mde_v2() Error: not a version 2 mde file" << std::endl;
+        return false;
+    }
+
+    view.header = header;
+
+    // the counts size the loader's arrays, the first block is the full mesh and has to exist
+    if (header->num_skins < 0 || header->num_verts < 0 || header->num_textcoords < 0
+            || header->num_frames < 1 || header->num_blocks < 1
+            || (int64_t)header->num_verts * header->num_frames > INT32_MAX) {
+        std::cerr << "read_mde_v2() Error: invalid header counts" << std::endl;
+        return false;
+    }
+
+    size_t num_verts = (size_t)header->num_verts * header->num_frames;
+    bool valid = map_section(data, size, header->skins, header->num_skins, view.skins);
+
+    for (int i = 0; i < 3; i++) {
+        valid = valid && map_section(data, size, header->positions[i], num_verts, view.positions[i]);
+        valid = valid && map_section(data, size, header->normals[i], num_verts, view.normals[i]);
+    }
+
+    for (int i = 0; i < 2; i++)
+        valid = valid && map_section(data, size, header->text_coords[i], header->num_textcoords, view.text_coords[i]);
+
+    const MdePolyBlock *blocks = nullptr;
+    valid = valid && map_section(data, size, header->blocks, header->num_blocks, blocks);
+
+    if (!valid) {
+        std::cerr << "read_mde_v2() Error: section out of bounds" << std::endl;
+        return false;
+    }
+
+    view.blocks.resize(header->num_blocks);
+
+    for (int i = 0; i < header->num_blocks; i++) {
+        auto &block = blocks[i];
+        auto &view_block = view.blocks[i];
+
+        if (block.num_polys < 0) {
+            valid = false;
+            break;
+        }
+
+        view_block.num_polys = block.num_polys;
+
+        valid = valid && map_section(data, size, block.vertex_indices, (size_t)block.num_polys * 3, view_block.vertex_indices);
+        valid = valid && map_section(data, size, block.text_indices, (size_t)block.num_polys * 3, view_block.text_indices);
+
+        for (int j = 0; j < 3; j++)
+            valid = valid && map_section(data, size, block.face_normals[j], block.num_polys, view_block.face_normals[j]);
+    }
+
+    if (!valid) {
+        std::cerr << "read_mde_v2() Error: poly block out of bounds" << std::endl;
+        return false;
+    }
+
+    // the indices are written into the mesh arrays while loading, so all of them have to point inside
+    for (const auto &block : view.blocks) {
+        for (size_t i = 0; i < (size_t)block.num_polys * 3; i++) {
+            if (block.vertex_indices[i] >= header->num_verts
+                    || (header->num_textcoords > 0 && block.text_indices[i] >= header->num_textcoords)) {
+                std::cerr << "read_mde_v2() Error: poly index out of range" << std::endl;
+                return false;
+            }
+        }
+    }
 
     return true;
 }
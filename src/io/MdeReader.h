@@ -1,7 +1,10 @@
+#pragma once
+
 #include <fstream>
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 struct MdeHeader {
     int version;
@@ -26,7 +29,7 @@ struct MdeHeader {
 
 
 std::ofstream& operator<<(std::ofstream& out, const MdeHeader &header);
-std::ifstream& operator>>(std::ifstream& in, const MdeHeader &header);
+std::istream& operator>>(std::istream& in, const MdeHeader &header);
 
 struct MdePoly {
     unsigned short v_index[3];
@@ -48,6 +51,13 @@ struct MdeFrame {
     MdeVert vlist[1];
 };
 
+/*
+ * Optional sections follow offset_end and start with a four character tag. The levels of
+ * detail section holds int num_lods, then for every level int num_polys and its polys. The
+ * polys index the vertices of the full mesh.
+ */
+static constexpr char MdeLodsTag[4] = { 'L', 'O', 'D', 'S' };
+
 struct MdeFile {
     MdeHeader header;
 
@@ -56,8 +66,94 @@ struct MdeFile {
     std::unique_ptr<MdeTextCoord> text_coords;
     std::unique_ptr<MdePoly> polys;
     std::unique_ptr<MdeFrame> frames;
+
+    // reduced levels of detail, the full mesh is not part of it
+    std::vector<std::vector<MdePoly>> lods;
+};
+
+/*
+ * Version 2 is laid out to be used straight from a memory mapping. Every section starts at a
+ * multiple of MdeAlignment and the vertex data is stored as separate arrays per component.
+ * Normals, face normals and bounds are computed by the converter. All offsets are relative to
+ * the start of the file. Both versions start with the version number.
+ */
+static constexpr int MdeVersion2 = 2;
+static constexpr int MdeAlignment = 64;
+static constexpr char MdeMagic[4] = { 'M', 'D', 'E', '2' };
+
+struct MdeSection {
+    uint32_t offset;
+    uint32_t size;
+};
+
+/* polygons of one level of detail, block 0 is the full mesh */
+struct MdePolyBlock {
+    int32_t num_polys;
+
+    // uint16_t[3] per poly
+    MdeSection vertex_indices;
+    MdeSection text_indices;
+
+    // unnormalized face normals of the first frame, float x, y and z
+    MdeSection face_normals[3];
+};
+
+struct MdeHeaderV2 {
+    int32_t version;
+    char magic[4];
+
+    int32_t num_skins;
+    int32_t num_verts;
+    int32_t num_textcoords;
+    int32_t num_frames;
+    int32_t num_blocks;
+
+    // over all frames, the radius is measured from the origin
+    float bounds_min[3];
+    float bounds_max[3];
+    float radius;
+
+    // char[64] per skin
+    MdeSection skins;
+
+    // float per vertex, frame after frame
+    MdeSection positions[3];
+    MdeSection normals[3];
+
+    // float u and v
+    MdeSection text_coords[2];
+
+    // MdePolyBlock per level of detail
+    MdeSection blocks;
+};
+
+/* pointers into a version 2 file, nothing is copied */
+struct MdeView {
+    const MdeHeaderV2 *header;
+
+    const char (*skins)[64];
+
+    const float *positions[3];
+    const float *normals[3];
+    const float *text_coords[2];
+
+    struct Block {
+        int num_polys;
+
+        const uint16_t *vertex_indices;
+        const uint16_t *text_indices;
+        const float *face_normals[3];
+    };
+
+    std::vector<Block> blocks;
 };
 
+/* returns the version of the file in data, 0 if it is too small to tell */
+int mde_version(const char *data, size_t size);
+
+/* checks that every section of the version 2 file lies within the data and sets up the view */
+bool read_mde_v2(const char *data, size_t size, MdeView &view);
+
 class MdeReader {
 public:
     MdeReader() = default;
@@ -71,8 +167,13 @@ public:
     ~MdeReader();
 
     bool read_file(std::string path, MdeFile &result);
+
+    /* reads a version 1 file that is already in memory */
+    bool read_memory(const char *data, size_t size, MdeFile &result);
 private:
     std::ifstream m_ifs;
+
+    bool read_stream(std::istream &in, MdeFile &result);
 };
 
 
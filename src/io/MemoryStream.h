@@ -0,0 +1,44 @@
+#pragma once
+
+#include <istream>
+#include <streambuf>
+#include <cstddef>
+
+/*
+ * Input stream over a block of memory that belongs to somebody else, so the readers that
+ * work on streams can parse archive entries and mapped files without a copy.
+ */
+class MemoryStream : public std::istream {
+public:
+    MemoryStream(const char *data, size_t size) : std::istream(&m_buffer), m_buffer(data, size) {}
+private:
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(const char *data, size_t size) {
+            auto begin = const_cast<char*>(data);
+            setg(begin, begin, begin + size);
+        }
+    protected:
+        pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+            char *base = eback();
+
+            if (dir == std::ios_base::cur)
+                offset += gptr() - base;
+            else if (dir == std::ios_base::end)
+                offset += egptr() - base;
+
+            if (offset < 0 || offset > egptr() - base)
+                return pos_type(off_type(-1));
+
+            setg(base, base + offset, egptr());
+
+            return pos_type(offset);
+        }
+
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+            return seekoff(off_type(pos), std::ios_base::beg, which);
+        }
+    };
+
+    Buffer m_buffer;
+};
@@ -0,0 +1,41 @@
+#include <iostream>
+#include <cstring>
+
+#include "MtcReader.h"
+
+bool read_mtc(const char *data, size_t size, MtcView &view) {
+    if (size < sizeof(MtcHeader))
+        return false;
+
+    auto header = reinterpret_cast<const MtcHeader*>(data);
+
+    if (std::memcmp(header->magic, MtcMagic, sizeof(MtcMagic)) != 0 || header->version != MtcVersion) {
+        std::cerr << "read_mtc() Error: not a mip texture container" << std::endl;
+        return false;
+    }
+
+    if (header->num_levels < 0 || sizeof(MtcHeader) + header->num_levels * sizeof(MtcLevel) > size)
+        return false;
+
+    auto levels = reinterpret_cast<const MtcLevel*>(data + sizeof(MtcHeader));
+
+    view.levels.clear();
+
+    for (int i = 0; i < header->num_levels; i++) {
+        auto &level = levels[i];
+
+        if (level.width <= 0 || level.height <= 0 || level.offset % MtcAlignment != 0
+                || level.size < (size_t)level.width * level.height * sizeof(uint32_t)
+                || (size_t)level.offset + level.size > size) {
+            std::cerr << "read_mtc() Error: level " << i << " out of bounds" << std::endl;
+            return false;
+        }
+
+        view.levels.push_back(MtcView::Level {
+            level.width, level.height,
+            reinterpret_cast<const uint32_t*>(data + level.offset)
+        });
+    }
+
+    return true;
+}
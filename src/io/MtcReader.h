@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Mip texture container. Holds every mip level of a texture in the pixel format of
+ * Graphics::Texture, one uint32_t per pixel, so the levels can be used straight from a
+ * memory mapping. The level table follows the header, every level starts at a multiple of
+ * MtcAlignment from the start of the file.
+ */
+static constexpr char MtcMagic[4] = { 'M', 'T', 'C', '1' };
+static constexpr int MtcVersion = 1;
+static constexpr int MtcAlignment = 64;
+
+struct MtcHeader {
+    char magic[4];
+    int32_t version;
+    int32_t num_levels;
+    int32_t reserved;
+};
+
+struct MtcLevel {
+    int32_t width;
+    int32_t height;
+
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct MtcView {
+    struct Level {
+        int width;
+        int height;
+
+        const uint32_t *pixels;
+    };
+
+    std::vector<Level> levels;
+};
+
+/* checks the header and that every level lies within the data, nothing is copied */
+bool read_mtc(const char *data, size_t size, MtcView &view);
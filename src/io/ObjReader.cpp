@@ -1,112 +1,275 @@
-#include <sstream>
-#include <fstream>
-#include <map>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
 
 #include "ObjReader.h"
+#include "MappedFile.h"
 
-ObjReader::ObjReader() {
+// ranges below this size aren't worth a thread
+static constexpr size_t MinChunkSize = 256 * 1024;
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* skip_spaces(const char *pos, const char *end) {
+    while (pos < end && is_space(*pos))
+        pos++;
+
+    return pos;
+}
+
+static const char* parse_int(const char *pos, const char *end, int &value) {
+    bool negative = false;
+    if (pos < end && (*pos == '-' || *pos == '+'))
+        negative = *pos++ == '-';
+
+    int result = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9')
+        result = result * 10 + (*pos++ - '0');
 
+    value = negative ? -result : result;
+
+    return pos;
 }
 
-bool ObjReader::read_file(string path) {
-    std::ifstream fs(path);
+static const char* parse_float(const char *pos, const char *end, float &value) {
+    // powers of ten that are exact in a double
+    static constexpr double Pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    pos = skip_spaces(pos, end);
 
+    bool negative = false;
+    if (pos < end && (*pos == '-' || *pos == '+'))
+        negative = *pos++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+        // digits past what fits in the mantissa only move the exponent
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*pos - '0');
+            if (mantissa != 0)
+                digits++;
+        } else {
+            exponent++;
+        }
+    }
+
+    if (pos < end && *pos == '.') {
+        pos++;
+
+        for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*pos - '0');
+                exponent--;
+                if (mantissa != 0)
+                    digits++;
+            }
+        }
+    }
+
+    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+        int exp_value;
+        pos = parse_int(pos + 1, end, exp_value);
+        exponent += exp_value;
+    }
+
+    double result = mantissa;
+
+    while (exponent > 22) {
+        result *= 1e22;
+        exponent -= 22;
+    }
+
+    while (exponent < -22) {
+        result /= 1e22;
+        exponent += 22;
+    }
+
+    result = exponent < 0 ? result / Pow10[-exponent] : result * Pow10[exponent];
+
+    value = negative ? -result : result;
+
+    return pos;
+}
+
+ObjReader::ObjReader() {
+
+}
+
+bool ObjReader::read_file(string path, int num_threads) {
     m_vertices.clear();
     m_tex_coords.clear();
     m_indices.clear();
     m_normals.clear();
 
-    if (!fs.is_open())
+    MappedFile file;
+    if (!file.open(path))
         return false;
 
-    while(!fs.eof()) {
-        char line[128];
+    const char *data = file.data();
+    const char *data_end = data + file.size();
+
+    if (num_threads <= 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    int num_chunks = std::max<size_t>(1, std::min<size_t>(num_threads, file.size() / MinChunkSize));
 
-        fs.getline(line, sizeof(line));
+    if (num_chunks == 1) {
+        parse_range(data, data_end);
+        return true;
+    }
+
+    // every range ends after a newline, so no line is split between two readers
+    vector<const char*> bounds { data };
+
+    for (int i = 1; i < num_chunks; i++) {
+        const char *pos = std::max(bounds.back(), data + file.size() * i / num_chunks);
+
+        while (pos < data_end && *pos != '\n')
+            pos++;
+
+        bounds.push_back(pos < data_end ? pos + 1 : data_end);
+    }
+
+    bounds.push_back(data_end);
+
+    vector<ObjReader> chunks(num_chunks);
+    vector<std::thread> threads;
+
+    for (int i = 1; i < num_chunks; i++)
+        threads.emplace_back(&ObjReader::parse_range, &chunks[i], bounds[i], bounds[i + 1]);
+
+    chunks[0].parse_range(bounds[0], bounds[1]);
 
-        std::stringstream ss;
-        vector<string> tokens;
-        ss << line;
+    for (auto &thread : threads)
+        thread.join();
 
-        string first_token;
-        ss >> first_token;
+    size_t num_vertices = 0, num_tex_coords = 0, num_normals = 0, num_indices = 0;
+
+    for (const auto &chunk : chunks) {
+        num_vertices += chunk.m_vertices.size();
+        num_tex_coords += chunk.m_tex_coords.size();
+        num_normals += chunk.m_normals.size();
+        num_indices += chunk.m_indices.size();
+    }
+
+    m_vertices.reserve(num_vertices);
+    m_tex_coords.reserve(num_tex_coords);
+    m_normals.reserve(num_normals);
+    m_indices.reserve(num_indices);
+
+    for (auto &chunk : chunks) {
+        m_vertices.insert(m_vertices.end(), chunk.m_vertices.begin(), chunk.m_vertices.end());
+        m_tex_coords.insert(m_tex_coords.end(), chunk.m_tex_coords.begin(), chunk.m_tex_coords.end());
+        m_normals.insert(m_normals.end(), chunk.m_normals.begin(), chunk.m_normals.end());
+        m_indices.insert(m_indices.end(), chunk.m_indices.begin(), chunk.m_indices.end());
+
+        has_tex_coords |= chunk.has_tex_coords;
+        has_normal_indices |= chunk.has_normal_indices;
+    }
+
+    return true;
+}
 
-        if (first_token == "v") {
+void ObjReader::parse_range(const char *pos, const char *end) {
+    // the corners of the current face, faces with more corners are rare
+    vector<ObjIndex> corners;
+
+    while (pos < end) {
+        const char *line_end = pos;
+        while (line_end < end && *line_end != '\n')
+            line_end++;
+
+        pos = skip_spaces(pos, line_end);
+
+        if (pos < line_end && pos[0] == 'v' && pos + 1 < line_end && is_space(pos[1])) {
             float x, y, z;
-            ss >> x >> y >> z;
+            pos = parse_float(pos + 1, line_end, x);
+            pos = parse_float(pos, line_end, y);
+            pos = parse_float(pos, line_end, z);
 
             // Wavefront .obj files are exported for a right handed coordinate system.
             // Thats why the x-axis is inversed for our left handed coordinate engine.
             m_vertices.push_back(V4D(x * -1.0f, y, z));
-        }
-
-        if (first_token == "vt") {
+        } else if (line_end - pos > 2 && pos[0] == 'v' && pos[1] == 't' && is_space(pos[2])) {
             float x, y;
-            ss >> x >> y;
+            pos = parse_float(pos + 2, line_end, x);
+            pos = parse_float(pos, line_end, y);
 
             // Wavefront .obj files output the uv coordinate system with the y-axis starting at the bottom.
             // This engine however expects y = 0 to start at the top. So the y values of textures have to be inversed.
             m_tex_coords.push_back(Math::V2D(x, 1.0f - y));
-        }
-
-        if (first_token == "vn") {
+        } else if (line_end - pos > 2 && pos[0] == 'v' && pos[1] == 'n' && is_space(pos[2])) {
             float x, y, z;
-            ss >> x >> y >> z;
+            pos = parse_float(pos + 2, line_end, x);
+            pos = parse_float(pos, line_end, y);
+            pos = parse_float(pos, line_end, z);
 
             // Wavefront .obj files are exported for a right handed coordinate system.
             // Thats why the normal x-axis is inversed for our left handed coordinate engine.
             m_normals.push_back(V4D(x * -1.0f, y, z, 0)); // normals dont have positions so w == 0
-        }
+        } else if (pos < line_end && pos[0] == 'f' && pos + 1 < line_end && is_space(pos[1])) {
+            corners.clear();
+            pos = skip_spaces(pos + 1, line_end);
 
-        if (first_token == "f") {
-            vector<string> tokens;
-            string value;
+            while (pos < line_end) {
+                ObjIndex corner;
+                pos = parse_object_index(pos, line_end, corner);
+                corners.push_back(corner);
 
-            while(std::getline(ss, value, ' '))
-                tokens.push_back(value);
+                pos = skip_spaces(pos, line_end);
+            }
 
-            for (int i = 0; i < tokens.size() - 3; i++) {
+            for (int i = 0; i + 3 <= (int)corners.size(); i++) {
                 // Wavefront .obj files are exported for a right handed coordinate system.
                 // Therefore we load load the faces in reverse order to have the face to the outside rather than the inside.
-                m_indices.push_back(parse_object_index(tokens[3 + i]));
-                m_indices.push_back(parse_object_index(tokens[2 + i]));
-                m_indices.push_back(parse_object_index(tokens[1]));
+                m_indices.push_back(corners[2 + i]);
+                m_indices.push_back(corners[1 + i]);
+                m_indices.push_back(corners[0]);
             }
         }
-    }
 
-    fs.close();
-    return true;
+        pos = line_end + 1;
+    }
 }
 
-ObjIndex ObjReader::parse_object_index(string token) {
-    ObjIndex result;
-    std::stringstream ss;
-    ss << token;
+const char* ObjReader::parse_object_index(const char *pos, const char *end, ObjIndex &result) {
+    int value;
 
-    int i = 0;
-    string value;
+    // v, v/t, v//n or v/t/n
+    pos = parse_int(pos, end, value);
+    result.vertex_index = value - 1;
 
-    while(std::getline(ss, value, '/')) {
-        if (value == "") {
-            i++;
-            continue;
-        }
+    if (pos < end && *pos == '/') {
+        pos++;
 
-        if (i == 0) {
-            result.vertex_index = std::stoi(value) - 1;
-        } else if (i == 1) {
-            result.tex_coord_index = std::stoi(value) - 1;
+        if (pos < end && *pos != '/' && !is_space(*pos)) {
+            pos = parse_int(pos, end, value);
+            result.tex_coord_index = value - 1;
             has_tex_coords = true;
-        } else if(i == 2) {
-            result.normal_index = std::stoi(value) - 1;
-            has_normal_indices = true;
-            break;
         }
 
-        i++;
+        if (pos < end && *pos == '/') {
+            pos++;
+
+            if (pos < end && !is_space(*pos)) {
+                pos = parse_int(pos, end, value);
+                result.normal_index = value - 1;
+                has_normal_indices = true;
+            }
+        }
     }
 
-    return result;
-}
+    // anything unexpected in the token is skipped
+    while (pos < end && !is_space(*pos))
+        pos++;
 
+    return pos;
+}
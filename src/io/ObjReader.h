@@ -10,15 +10,23 @@ using std::string;
 using std::vector;
 
 struct ObjIndex {
-    int vertex_index;
-    int tex_coord_index;
-    int normal_index;
+    // -1 when the face doesn't reference one
+    int vertex_index = -1;
+    int tex_coord_index = -1;
+    int normal_index = -1;
 };
 
+/*
+ * Wavefront .obj reader. The file is mapped and parsed in place, without building strings.
+ * Large files are split at line boundaries and the ranges are parsed on separate threads,
+ * face indices are absolute so the results only have to be appended in order.
+ */
 class ObjReader {
 public:
     ObjReader();
-    bool read_file(string path);
+
+    /* 0 threads = one per core, files smaller than a few chunks always parse on the calling thread */
+    bool read_file(string path, int num_threads = 0);
 
     vector<V4D> m_vertices;
     vector<Math::V2D> m_tex_coords;
@@ -28,6 +36,6 @@ public:
     bool has_tex_coords = false;
     bool has_normal_indices = false;
 private:
-    ObjIndex parse_object_index(string token);
+    void parse_range(const char *begin, const char *end);
+    const char* parse_object_index(const char *pos, const char *end, ObjIndex &result);
 };
-
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#include "PakReader.h"
+#include "Lz.h"
+
+bool PakReader::open(const std::string &path) {
+    if (!m_file.open(path))
+        return false;
+
+    auto data = m_file.data();
+    auto size = m_file.size();
+
+    auto header = reinterpret_cast<const PakHeader*>(data);
+
+    if (size < sizeof(PakHeader) || std::memcmp(header->magic, PakMagic, sizeof(PakMagic)) != 0
+            || header->version != PakVersion) {
+        std::cerr << "PakReader::open() Error: " << path << " is not an archive" << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    size_t index_size = header->num_entries * sizeof(PakEntry);
+
+    if (header->num_entries < 0 || sizeof(PakHeader) + index_size + header->names_size > size) {
+        std::cerr << "PakReader::open() Error: index of " << path << " out of bounds" << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    p_entries = reinterpret_cast<const PakEntry*>(data + sizeof(PakHeader));
+    p_names = data + sizeof(PakHeader) + index_size;
+
+    m_num_entries = header->num_entries;
+    m_names_size = header->names_size;
+
+    for (int i = 0; i < m_num_entries; i++) {
+        auto &entry = p_entries[i];
+
+        if (entry.offset + entry.packed_size > size || entry.name_offset >= m_names_size) {
+            std::cerr << "PakReader::open() Error: entry " << i << " of " << path << " out of bounds" << std::endl;
+            m_file.close();
+            m_num_entries = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const PakEntry* PakReader::find(const std::string &name) const {
+    uint64_t hash = pak_hash(name.data(), name.size());
+
+    auto end = p_entries + m_num_entries;
+    auto entry = std::lower_bound(p_entries, end, hash, [](const PakEntry &entry, uint64_t hash) {
+        return entry.hash < hash;
+    });
+
+    // the names settle hash collisions
+    for (; entry != end && entry->hash == hash; entry++) {
+        auto entry_name = p_names + entry->name_offset;
+
+        if (strnlen(entry_name, m_names_size - entry->name_offset) == name.size()
+                && std::memcmp(entry_name, name.data(), name.size()) == 0)
+            return entry;
+    }
+
+    return nullptr;
+}
+
+bool PakReader::read(const PakEntry &entry, std::vector<char> &buffer) const {
+    buffer.resize(entry.size);
+
+    if (!(entry.flags & PakEntryCompressed)) {
+        if (entry.packed_size != entry.size)
+            return false;
+
+        std::memcpy(buffer.data(), entry_data(entry), entry.size);
+        return true;
+    }
+
+    return lz_decompress(entry_data(entry), entry.packed_size, buffer.data(), entry.size);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+/*
+ * Asset archive. The header is followed by the index, sorted by the hash of the entry names,
+ * and the name table, so a lookup is a binary search in the first pages of the file. Entry data
+ * starts at multiples of PakAlignment. Entries are stored LZ compressed (see Lz.h) when that
+ * pays off, formats that are used straight from a mapping are stored as they are.
+ */
+static constexpr char PakMagic[4] = { 'P', 'A', 'K', '1' };
+static constexpr int PakVersion = 1;
+static constexpr int PakAlignment = 64;
+
+static constexpr uint32_t PakEntryCompressed = 1;
+
+struct PakHeader {
+    char magic[4];
+    int32_t version;
+    int32_t num_entries;
+    uint32_t names_size;
+};
+
+struct PakEntry {
+    uint64_t hash;
+    uint64_t offset;
+
+    uint32_t size;
+    uint32_t packed_size;
+
+    // offset into the name table, names are zero terminated
+    uint32_t name_offset;
+    uint32_t flags;
+};
+
+/* 64 bit FNV-1a */
+constexpr uint64_t pak_hash(const char *name, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+class PakReader {
+public:
+    PakReader() = default;
+
+    PakReader(const PakReader &other) = delete;
+    PakReader& operator=(const PakReader &other) = delete;
+
+    bool open(const std::string &path);
+
+    /* returns nullptr when the archive has no entry of that name */
+    const PakEntry* find(const std::string &name) const;
+
+    /* the stored bytes of the entry, only its content when it isn't compressed */
+    const char* entry_data(const PakEntry &entry) const {
+        return m_file.data() + entry.offset;
+    }
+
+    /* decompresses or copies the entry into buffer */
+    bool read(const PakEntry &entry, std::vector<char> &buffer) const;
+
+    int get_num_entries() const {
+        return m_num_entries;
+    }
+private:
+    MappedFile m_file;
+
+    const PakEntry *p_entries = nullptr;
+    const char *p_names = nullptr;
+
+    int m_num_entries = 0;
+    uint32_t m_names_size = 0;
+};
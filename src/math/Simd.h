@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+ * Thin wrappers around the float SIMD registers of the target. Builds with -mavx get 8 lanes,
+ * plain x86-64 builds get SSE with 4 lanes and anything else falls back to a single lane.
+ */
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Math {
+
+#if defined(__AVX__)
+
+using VFloat = __m256;
+static constexpr int SimdWidth = 8;
+
+inline VFloat v_set(float f) { return _mm256_set1_ps(f); }
+inline VFloat v_load(const float *p) { return _mm256_loadu_ps(p); }
+inline void v_store(float *p, VFloat v) { _mm256_storeu_ps(p, v); }
+
+inline VFloat v_add(VFloat a, VFloat b) { return _mm256_add_ps(a, b); }
+inline VFloat v_sub(VFloat a, VFloat b) { return _mm256_sub_ps(a, b); }
+inline VFloat v_mul(VFloat a, VFloat b) { return _mm256_mul_ps(a, b); }
+inline VFloat v_div(VFloat a, VFloat b) { return _mm256_div_ps(a, b); }
+inline VFloat v_min(VFloat a, VFloat b) { return _mm256_min_ps(a, b); }
+inline VFloat v_max(VFloat a, VFloat b) { return _mm256_max_ps(a, b); }
+inline VFloat v_sqrt(VFloat a) { return _mm256_sqrt_ps(a); }
+
+#elif defined(__SSE2__)
+
+using VFloat = __m128;
+static constexpr int SimdWidth = 4;
+
+inline VFloat v_set(float f) { return _mm_set1_ps(f); }
+inline VFloat v_load(const float *p) { return _mm_loadu_ps(p); }
+inline void v_store(float *p, VFloat v) { _mm_storeu_ps(p, v); }
+
+inline VFloat v_add(VFloat a, VFloat b) { return _mm_add_ps(a, b); }
+inline VFloat v_sub(VFloat a, VFloat b) { return _mm_sub_ps(a, b); }
+inline VFloat v_mul(VFloat a, VFloat b) { return _mm_mul_ps(a, b); }
+inline VFloat v_div(VFloat a, VFloat b) { return _mm_div_ps(a, b); }
+inline VFloat v_min(VFloat a, VFloat b) { return _mm_min_ps(a, b); }
+inline VFloat v_max(VFloat a, VFloat b) { return _mm_max_ps(a, b); }
+inline VFloat v_sqrt(VFloat a) { return _mm_sqrt_ps(a); }
+
+#else
+
+using VFloat = float;
+static constexpr int SimdWidth = 1;
+
+inline VFloat v_set(float f) { return f; }
+inline VFloat v_load(const float *p) { return *p; }
+inline void v_store(float *p, VFloat v) { *p = v; }
+
+inline VFloat v_add(VFloat a, VFloat b) { return a + b; }
+inline VFloat v_sub(VFloat a, VFloat b) { return a - b; }
+inline VFloat v_mul(VFloat a, VFloat b) { return a * b; }
+inline VFloat v_div(VFloat a, VFloat b) { return a / b; }
+inline VFloat v_min(VFloat a, VFloat b) { return a < b ? a : b; }
+inline VFloat v_max(VFloat a, VFloat b) { return a > b ? a : b; }
+inline VFloat v_sqrt(VFloat a) { return __builtin_sqrtf(a); }
+
+#endif
+
+}
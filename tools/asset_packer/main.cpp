@@ -0,0 +1,193 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+#include "../../src/io/PakReader.h"
+#include "../../src/io/Lz.h"
+
+using std::string;
+using std::vector;
+
+struct PackedFile {
+    string name;
+
+    vector<char> data;
+    PakEntry entry;
+};
+
+bool collect_files(string path, vector<string> &file_paths);
+bool pack_files(const vector<string> &file_paths, string output_path, bool compress);
+bool is_mappable(const vector<char> &data);
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> argument_inputs;
+
+    for (int i = 0; i < argc; i++)
+        argument_inputs.push_back(std::string(argv[i]));
+
+    vector<string> input_paths;
+    std::string output_path;
+
+    bool compress = true;
+
+    for (size_t i = 1; i < argument_inputs.size(); i++) {
+        if (argument_inputs[i] == "-i") {
+            input_paths.push_back(argument_inputs[i + 1]);
+        }
+
+        if (argument_inputs[i] == "-o") {
+            output_path = argument_inputs[i + 1];
+        }
+
+        if (argument_inputs[i] == "-u") {
+            compress = false;
+        }
+    }
+
+    if (input_paths.empty() || output_path.empty()) {
+        printf("Usage: asset_packer -i <file or directory> [-i ...] -o <archive.pak> [-u]\n");
+        return 1;
+    }
+
+    vector<string> file_paths;
+
+    for (const auto &path : input_paths) {
+        if (!collect_files(path, file_paths))
+            return 1;
+    }
+
+    return pack_files(file_paths, output_path, compress) ? 0 : 1;
+}
+
+bool collect_files(string path, vector<string> &file_paths) {
+    if (std::filesystem::is_regular_file(path)) {
+        file_paths.push_back(path);
+        return true;
+    }
+
+    if (!std::filesystem::is_directory(path)) {
+        printf("%s not found\n", path.c_str());
+        return false;
+    }
+
+    // entries are named like the engine asks for them, relative to the working directory
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file())
+            file_paths.push_back(entry.path().generic_string());
+    }
+
+    return true;
+}
+
+bool is_mappable(const vector<char> &data) {
+    // mip texture containers and version 2 meshes are used straight from the mapping
+    return data.size() >= 8 && (std::memcmp(data.data(), "MTC1", 4) == 0 || std::memcmp(data.data() + 4, "MDE2", 4) == 0);
+}
+
+bool pack_files(const vector<string> &file_paths, string output_path, bool compress) {
+    vector<PackedFile> files;
+
+    for (const auto &path : file_paths) {
+        std::ifstream fs(path, std::ios::in | std::ios::binary);
+        if (!fs.is_open()) {
+            printf("Could not read %s\n", path.c_str());
+            return false;
+        }
+
+        PackedFile file;
+        file.name = path;
+        file.data.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+
+        std::memset(&file.entry, 0, sizeof(PakEntry));
+        file.entry.hash = pak_hash(file.name.data(), file.name.size());
+        file.entry.size = file.data.size();
+        file.entry.packed_size = file.data.size();
+
+        if (compress && !is_mappable(file.data)) {
+            vector<char> packed;
+            lz_compress(file.data.data(), file.data.size(), packed);
+
+            if (packed.size() < file.data.size()) {
+                file.data.swap(packed);
+                file.entry.packed_size = file.data.size();
+                file.entry.flags |= PakEntryCompressed;
+            }
+        }
+
+        files.push_back(std::move(file));
+    }
+
+    std::sort(files.begin(), files.end(), [](const PackedFile &a, const PackedFile &b) {
+        return a.entry.hash < b.entry.hash;
+    });
+
+    for (size_t i = 1; i < files.size(); i++) {
+        if (files[i].name == files[i - 1].name) {
+            printf("%s was added twice\n", files[i].name.c_str());
+            return false;
+        }
+    }
+
+    vector<char> names;
+    for (auto &file : files) {
+        file.entry.name_offset = names.size();
+        names.insert(names.end(), file.name.begin(), file.name.end());
+        names.push_back('\0');
+    }
+
+    PakHeader header {};
+    std::memcpy(header.magic, PakMagic, sizeof(PakMagic));
+    header.version = PakVersion;
+    header.num_entries = files.size();
+    header.names_size = names.size();
+
+    uint64_t offset = sizeof(PakHeader) + sizeof(PakEntry) * files.size() + names.size();
+
+    for (auto &file : files) {
+        offset = (offset + PakAlignment - 1) / PakAlignment * PakAlignment;
+
+        file.entry.offset = offset;
+        offset += file.data.size();
+    }
+
+    vector<char> data(offset, 0);
+    char *out = data.data();
+
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (const auto &file : files) {
+        std::memcpy(out, &file.entry, sizeof(PakEntry));
+        out += sizeof(PakEntry);
+    }
+
+    std::memcpy(out, names.data(), names.size());
+
+    size_t total_size = 0;
+
+    for (const auto &file : files) {
+        std::memcpy(data.data() + file.entry.offset, file.data.data(), file.data.size());
+        total_size += file.entry.size;
+
+        printf("%s: %u -> %u bytes%s\n", file.name.c_str(), file.entry.size, file.entry.packed_size,
+                file.entry.flags & PakEntryCompressed ? "" : " (stored)");
+    }
+
+    std::ofstream fs(output_path, std::ios::out | std::ios::binary);
+    if (!fs.is_open()) {
+        printf("Could not write %s\n", output_path.c_str());
+        return false;
+    }
+
+    fs.write(data.data(), data.size());
+    fs.close();
+
+    printf("%s: %zu files, %zu -> %zu bytes\n", output_path.c_str(), files.size(), total_size, data.size());
+
+    return true;
+}
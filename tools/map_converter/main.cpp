@@ -0,0 +1,99 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+
+#include "../../src/io/MapReader.h"
+
+using std::string;
+using std::vector;
+
+bool convert_map(string input_path, string output_path);
+bool write_map_data(string output_path, const MapFile &file);
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> argument_inputs;
+
+    for (int i = 0; i < argc; i++)
+        argument_inputs.push_back(std::string(argv[i]));
+
+    std::string input_path;
+    std::string output_path;
+
+    for (size_t i = 1; i < argument_inputs.size(); i++) {
+        if (argument_inputs[i] == "-i") {
+            input_path = argument_inputs[i + 1];
+        }
+
+        if (argument_inputs[i] == "-o") {
+            output_path = argument_inputs[i + 1];
+        }
+    }
+
+    if (input_path.empty() || output_path.empty()) {
+        printf("Usage: map_converter -i <terrain.map> -o <terrain.bmap>\n");
+        return 1;
+    }
+
+    return convert_map(input_path, output_path) ? 0 : 1;
+}
+
+bool convert_map(string input_path, string output_path) {
+    MapReader reader;
+    MapFile file;
+
+    if (!reader.read_file(input_path, file)) {
+        printf("Could not load map %s\n", input_path.c_str());
+        return false;
+    }
+
+    if (!write_map_data(output_path, file)) {
+        printf("Could not write %s\n", output_path.c_str());
+        return false;
+    }
+
+    printf("%s: %d x %d tiles\n", output_path.c_str(), file.width, file.farth);
+
+    return true;
+}
+
+bool write_map_data(string output_path, const MapFile &file) {
+    MapHeader header {};
+
+    std::memcpy(header.magic, MapMagic, sizeof(MapMagic));
+    header.version = MapVersion;
+    header.width = file.width;
+    header.farth = file.farth;
+
+    size_t num_tiles = (size_t)file.width * file.farth;
+    size_t plane_size = num_tiles * sizeof(uint16_t);
+
+    auto align = [](size_t offset) {
+        return (offset + MapAlignment - 1) / MapAlignment * MapAlignment;
+    };
+
+    header.heights_offset = align(sizeof(MapHeader));
+    header.terrains_offset = align(header.heights_offset + plane_size);
+
+    vector<char> data(header.terrains_offset + plane_size, 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    auto heights = reinterpret_cast<uint16_t*>(data.data() + header.heights_offset);
+    auto terrains = reinterpret_cast<uint16_t*>(data.data() + header.terrains_offset);
+
+    for (size_t i = 0; i < num_tiles; i++) {
+        heights[i] = file.ter_codes[i].height;
+        terrains[i] = file.ter_codes[i].terrain;
+    }
+
+    std::ofstream fs(output_path, std::ios::out | std::ios::binary);
+    if (!fs.is_open()) {
+        return false;
+    }
+
+    fs.write(data.data(), data.size());
+    fs.close();
+
+    return true;
+}
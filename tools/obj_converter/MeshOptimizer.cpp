@@ -0,0 +1,264 @@
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+
+// size of the simulated vertex cache and the scoring constants from Forsyth's paper
+static constexpr int CacheSize = 32;
+static constexpr float CacheDecayPower = 1.5f;
+static constexpr float LastTriScore = 0.75f;
+static constexpr float ValenceBoostScale = 2.0f;
+static constexpr float ValenceBoostPower = 0.5f;
+
+static float vertex_score(int cache_pos, int remaining_polys) {
+    if (remaining_polys == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cache_pos >= 0) {
+        // the vertices of the last polygon get a fixed score, so it isn't picked again right away
+        if (cache_pos < 3) {
+            score = LastTriScore;
+        } else {
+            float scaler = 1.0f / (CacheSize - 3);
+            score = std::pow(1.0f - (cache_pos - 3) * scaler, CacheDecayPower);
+        }
+    }
+
+    // vertices with few polygons left are finished first so they leave the cache for good
+    score += ValenceBoostScale * std::pow((float)remaining_polys, -ValenceBoostPower);
+
+    return score;
+}
+
+void optimize_poly_order(std::vector<MdePoly> &polys, int num_verts) {
+    int num_polys = polys.size();
+    if (num_polys == 0)
+        return;
+
+    std::vector<int> remaining(num_verts, 0);
+    for (const auto &poly : polys) {
+        for (int j = 0; j < 3; j++)
+            remaining[poly.v_index[j]]++;
+    }
+
+    // polygons per vertex, packed into one array
+    std::vector<int> vertex_polys_start(num_verts + 1, 0);
+    for (int v = 0; v < num_verts; v++)
+        vertex_polys_start[v + 1] = vertex_polys_start[v] + remaining[v];
+
+    std::vector<int> vertex_polys(vertex_polys_start[num_verts]);
+    std::vector<int> fill(vertex_polys_start.begin(), vertex_polys_start.end() - 1);
+
+    for (int p = 0; p < num_polys; p++) {
+        for (int j = 0; j < 3; j++) {
+            int v = polys[p].v_index[j];
+            vertex_polys[fill[v]++] = p;
+        }
+    }
+
+    std::vector<int> cache_pos(num_verts, -1);
+    std::vector<float> scores(num_verts);
+    for (int v = 0; v < num_verts; v++)
+        scores[v] = vertex_score(-1, remaining[v]);
+
+    std::vector<float> poly_scores(num_polys);
+    std::vector<bool> emitted(num_polys, false);
+
+    for (int p = 0; p < num_polys; p++)
+        poly_scores[p] = scores[polys[p].v_index[0]] + scores[polys[p].v_index[1]] + scores[polys[p].v_index[2]];
+
+    std::vector<int> cache;
+    std::vector<MdePoly> result;
+    result.reserve(num_polys);
+
+    int best_poly = 0;
+    for (int p = 1; p < num_polys; p++) {
+        if (poly_scores[p] > poly_scores[best_poly])
+            best_poly = p;
+    }
+
+    // where to continue the full search when the cache has no polygons left
+    int scan_start = 0;
+
+    while (best_poly >= 0) {
+        auto &poly = polys[best_poly];
+
+        emitted[best_poly] = true;
+        result.push_back(poly);
+
+        // move the vertices of the polygon to the front of the cache
+        std::vector<int> new_cache;
+        new_cache.reserve(CacheSize + 3);
+
+        for (int j = 0; j < 3; j++) {
+            int v = poly.v_index[j];
+            new_cache.push_back(v);
+
+            // take the polygon out of the list of the vertex
+            int start = vertex_polys_start[v];
+            int end = start + remaining[v];
+
+            for (int i = start; i < end; i++) {
+                if (vertex_polys[i] == best_poly) {
+                    vertex_polys[i] = vertex_polys[end - 1];
+                    break;
+                }
+            }
+
+            remaining[v]--;
+        }
+
+        for (int v : cache) {
+            if (v != poly.v_index[0] && v != poly.v_index[1] && v != poly.v_index[2])
+                new_cache.push_back(v);
+        }
+
+        for (int i = 0; i < (int)new_cache.size(); i++) {
+            int v = new_cache[i];
+
+            cache_pos[v] = i < CacheSize ? i : -1;
+            scores[v] = vertex_score(cache_pos[v], remaining[v]);
+        }
+
+        if ((int)new_cache.size() > CacheSize)
+            new_cache.resize(CacheSize);
+
+        cache.swap(new_cache);
+
+        // only the polygons around the cached vertices changed their score
+        best_poly = -1;
+        float best_score = -1.0f;
+
+        for (int v : cache) {
+            int start = vertex_polys_start[v];
+
+            for (int i = start; i < start + remaining[v]; i++) {
+                int p = vertex_polys[i];
+                auto &candidate = polys[p];
+
+                poly_scores[p] = scores[candidate.v_index[0]] + scores[candidate.v_index[1]] + scores[candidate.v_index[2]];
+
+                if (poly_scores[p] > best_score) {
+                    best_score = poly_scores[p];
+                    best_poly = p;
+                }
+            }
+        }
+
+        if (best_poly >= 0)
+            continue;
+
+        for (; scan_start < num_polys; scan_start++) {
+            if (!emitted[scan_start]) {
+                best_poly = scan_start;
+                break;
+            }
+        }
+    }
+
+    polys.swap(result);
+}
+
+void optimize_mesh(std::vector<std::vector<MdeVert>> &total_verts, std::vector<std::vector<MdePoly>> &total_polys,
+        std::vector<MdeTextCoord> &text_coords)
+{
+    int num_frames = total_verts.size();
+    int num_verts = total_verts[0].size();
+    int num_textcoords = text_coords.size();
+
+    // weld the vertices that are at the same place in every frame
+    std::vector<int> weld(num_verts);
+    {
+        std::unordered_map<std::string, int> positions;
+        std::string key(sizeof(MdeVert) * num_frames, '\0');
+
+        for (int v = 0; v < num_verts; v++) {
+            for (int frame = 0; frame < num_frames; frame++)
+                std::memcpy(&key[sizeof(MdeVert) * frame], &total_verts[frame][v], sizeof(MdeVert));
+
+            weld[v] = positions.emplace(key, v).first->second;
+        }
+    }
+
+    std::vector<int> weld_text(num_textcoords);
+    {
+        std::unordered_map<std::string, int> coords;
+
+        for (int t = 0; t < num_textcoords; t++) {
+            std::string key(reinterpret_cast<const char*>(&text_coords[t]), sizeof(MdeTextCoord));
+            weld_text[t] = coords.emplace(key, t).first->second;
+        }
+    }
+
+    for (auto &polys : total_polys) {
+        for (auto &poly : polys) {
+            for (int j = 0; j < 3; j++) {
+                poly.v_index[j] = weld[poly.v_index[j]];
+
+                if (num_textcoords > 0)
+                    poly.t_index[j] = weld_text[poly.t_index[j]];
+            }
+        }
+    }
+
+    // reorder the polygons of the first frame and bring the other frames in the same order
+    auto &base_polys = total_polys[0];
+    std::vector<MdePoly> ordered = base_polys;
+    optimize_poly_order(ordered, num_verts);
+
+    for (auto &polys : total_polys)
+        polys = ordered;
+
+    // number the vertices and texture coordinates by first use, unused ones are dropped
+    std::vector<int> vertex_map(num_verts, -1);
+    std::vector<int> text_map(num_textcoords, -1);
+    int next_vertex = 0;
+    int next_text = 0;
+
+    for (const auto &poly : ordered) {
+        for (int j = 0; j < 3; j++) {
+            if (vertex_map[poly.v_index[j]] < 0)
+                vertex_map[poly.v_index[j]] = next_vertex++;
+
+            if (num_textcoords > 0 && text_map[poly.t_index[j]] < 0)
+                text_map[poly.t_index[j]] = next_text++;
+        }
+    }
+
+    for (auto &verts : total_verts) {
+        std::vector<MdeVert> remapped(next_vertex);
+
+        for (int v = 0; v < num_verts; v++) {
+            if (vertex_map[v] >= 0)
+                remapped[vertex_map[v]] = verts[v];
+        }
+
+        verts.swap(remapped);
+    }
+
+    if (num_textcoords > 0) {
+        std::vector<MdeTextCoord> remapped(next_text);
+
+        for (int t = 0; t < num_textcoords; t++) {
+            if (text_map[t] >= 0)
+                remapped[text_map[t]] = text_coords[t];
+        }
+
+        text_coords.swap(remapped);
+    }
+
+    for (auto &polys : total_polys) {
+        for (auto &poly : polys) {
+            for (int j = 0; j < 3; j++) {
+                poly.v_index[j] = vertex_map[poly.v_index[j]];
+
+                if (num_textcoords > 0)
+                    poly.t_index[j] = text_map[poly.t_index[j]];
+            }
+        }
+    }
+}
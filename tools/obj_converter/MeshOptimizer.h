@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/io/MdeReader.h"
+
+/*
+ * Prepares a mesh for the order the pipeline walks it in. Vertices that have the same position
+ * in every frame and identical texture coordinates are welded, the polygons are reordered for
+ * vertex reuse and the vertices and texture coordinates are renumbered in order of first use.
+ * Every frame has to share the polygons of the first frame.
+ */
+void optimize_mesh(std::vector<std::vector<MdeVert>> &total_verts, std::vector<std::vector<MdePoly>> &total_polys,
+        std::vector<MdeTextCoord> &text_coords);
+
+/*
+ * Forsyth's linear speed vertex cache optimisation. Reorders the polygons so the ones that
+ * share vertices are close to each other, the vertices themselves keep their indices.
+ */
+void optimize_poly_order(std::vector<MdePoly> &polys, int num_verts);
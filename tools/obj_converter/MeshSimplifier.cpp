@@ -0,0 +1,304 @@
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <unordered_map>
+
+#include "MeshSimplifier.h"
+
+// weight of the planes that keep open borders from collapsing inwards
+static constexpr double BoundaryWeight = 1000.0;
+
+struct Vec3 {
+    double x, y, z;
+
+    Vec3 operator-(const Vec3 &rhs) const { return { x - rhs.x, y - rhs.y, z - rhs.z }; }
+
+    double dot(const Vec3 &rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z; }
+
+    Vec3 cross(const Vec3 &rhs) const {
+        return { y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x };
+    }
+
+    double length() const { return std::sqrt(dot(*this)); }
+};
+
+/* symmetric 4x4 matrix of the summed squared distances to a set of planes */
+struct Quadric {
+    double m[10] = {};
+
+    void add_plane(const Vec3 &n, double d, double weight) {
+        m[0] += weight * n.x * n.x; m[1] += weight * n.x * n.y; m[2] += weight * n.x * n.z; m[3] += weight * n.x * d;
+        m[4] += weight * n.y * n.y; m[5] += weight * n.y * n.z; m[6] += weight * n.y * d;
+        m[7] += weight * n.z * n.z; m[8] += weight * n.z * d;
+        m[9] += weight * d * d;
+    }
+
+    Quadric operator+(const Quadric &rhs) const {
+        Quadric q;
+        for (int i = 0; i < 10; i++)
+            q.m[i] = m[i] + rhs.m[i];
+
+        return q;
+    }
+
+    double error(const Vec3 &v) const {
+        return m[0] * v.x * v.x + 2 * m[1] * v.x * v.y + 2 * m[2] * v.x * v.z + 2 * m[3] * v.x
+            + m[4] * v.y * v.y + 2 * m[5] * v.y * v.z + 2 * m[6] * v.y
+            + m[7] * v.z * v.z + 2 * m[8] * v.z
+            + m[9];
+    }
+};
+
+struct Collapse {
+    double cost;
+
+    int from, to;
+    int from_version, to_version;
+
+    bool operator>(const Collapse &rhs) const { return cost > rhs.cost; }
+};
+
+static uint64_t edge_key(int a, int b) {
+    if (a > b)
+        std::swap(a, b);
+
+    return (uint64_t(a) << 32) | uint32_t(b);
+}
+
+std::vector<MdePoly> simplify_mesh(const std::vector<MdeVert> &verts, const std::vector<MdePoly> &polys,
+        int target_polys)
+{
+    int num_verts = verts.size();
+    int num_polys = polys.size();
+
+    if (num_polys <= target_polys)
+        return polys;
+
+    std::vector<Vec3> pos(num_verts);
+    for (int i = 0; i < num_verts; i++)
+        pos[i] = { verts[i].v[0], verts[i].v[1], verts[i].v[2] };
+
+    std::vector<MdePoly> faces = polys;
+    std::vector<bool> face_alive(num_polys, true);
+    std::vector<std::vector<int>> vertex_faces(num_verts);
+    std::vector<Quadric> quadrics(num_verts);
+
+    auto face_normal = [&](const MdePoly &face) {
+        auto &p0 = pos[face.v_index[0]];
+        return (pos[face.v_index[1]] - p0).cross(pos[face.v_index[2]] - p0);
+    };
+
+    std::unordered_map<uint64_t, int> edge_faces;
+    int live_faces = 0;
+
+    for (int f = 0; f < num_polys; f++) {
+        auto &face = faces[f];
+
+        if (face.v_index[0] == face.v_index[1] || face.v_index[1] == face.v_index[2] || face.v_index[0] == face.v_index[2]) {
+            face_alive[f] = false;
+            continue;
+        }
+
+        live_faces++;
+
+        for (int j = 0; j < 3; j++) {
+            vertex_faces[face.v_index[j]].push_back(f);
+            edge_faces[edge_key(face.v_index[j], face.v_index[(j + 1) % 3])]++;
+        }
+
+        auto n = face_normal(face);
+        double length = n.length();
+        if (length == 0)
+            continue;
+
+        // planes are weighted by the area of the polygon
+        Vec3 unit = { n.x / length, n.y / length, n.z / length };
+        double d = -unit.dot(pos[face.v_index[0]]);
+
+        for (int j = 0; j < 3; j++)
+            quadrics[face.v_index[j]].add_plane(unit, d, length * 0.5);
+    }
+
+    // an edge with a single polygon lies on a border, add a plane through it perpendicular to the polygon
+    for (int f = 0; f < num_polys; f++) {
+        if (!face_alive[f])
+            continue;
+
+        auto &face = faces[f];
+        auto n = face_normal(face);
+
+        for (int j = 0; j < 3; j++) {
+            int a = face.v_index[j];
+            int b = face.v_index[(j + 1) % 3];
+
+            if (edge_faces[edge_key(a, b)] != 1)
+                continue;
+
+            auto edge = pos[b] - pos[a];
+            auto border_n = edge.cross(n);
+            double length = border_n.length();
+            if (length == 0)
+                continue;
+
+            Vec3 unit = { border_n.x / length, border_n.y / length, border_n.z / length };
+            double d = -unit.dot(pos[a]);
+            double weight = BoundaryWeight * edge.dot(edge);
+
+            quadrics[a].add_plane(unit, d, weight);
+            quadrics[b].add_plane(unit, d, weight);
+        }
+    }
+
+    std::vector<int> collapsed_into(num_verts, -1);
+    std::vector<int> versions(num_verts, 0);
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+    auto push_edge = [&](int a, int b) {
+        auto q = quadrics[a] + quadrics[b];
+        double cost_ab = q.error(pos[b]);
+        double cost_ba = q.error(pos[a]);
+
+        if (cost_ab <= cost_ba)
+            heap.push({ cost_ab, a, b, versions[a], versions[b] });
+        else
+            heap.push({ cost_ba, b, a, versions[b], versions[a] });
+    };
+
+    for (auto &edge : edge_faces)
+        push_edge(edge.first >> 32, edge.first & 0xFFFFFFFF);
+
+    auto has_vertex = [](const MdePoly &face, int v) {
+        return face.v_index[0] == v || face.v_index[1] == v || face.v_index[2] == v;
+    };
+
+    auto corner_of = [](const MdePoly &face, int v) {
+        for (int j = 0; j < 3; j++) {
+            if (face.v_index[j] == v)
+                return j;
+        }
+
+        return -1;
+    };
+
+    // uv of the removed vertex -> uv of the target, one pair for every chart that meets at the edge
+    std::vector<std::pair<int, int>> text_coord_map;
+
+    auto mapped_text_coord = [&](int t_index) {
+        for (auto &pair : text_coord_map) {
+            if (pair.first == t_index)
+                return pair.second;
+        }
+
+        return -1;
+    };
+
+    while (live_faces > target_polys && !heap.empty()) {
+        auto collapse = heap.top();
+        heap.pop();
+
+        int from = collapse.from;
+        int to = collapse.to;
+
+        if (collapsed_into[from] != -1 || collapsed_into[to] != -1
+                || versions[from] != collapse.from_version || versions[to] != collapse.to_version)
+            continue;
+
+        // moving the vertex must not turn any of the remaining polygons around
+        bool flips = false;
+
+        for (int f : vertex_faces[from]) {
+            if (!face_alive[f] || has_vertex(faces[f], to))
+                continue;
+
+            auto moved = faces[f];
+            for (int j = 0; j < 3; j++) {
+                if (moved.v_index[j] == from)
+                    moved.v_index[j] = to;
+            }
+
+            if (face_normal(moved).dot(face_normal(faces[f])) <= 0) {
+                flips = true;
+                break;
+            }
+        }
+
+        if (flips)
+            continue;
+
+        // the polygons on the edge tell which uv of the target every uv of the removed vertex becomes,
+        // a corner that finds none is on a seam that doesn't follow the edge and would smear the texture
+        text_coord_map.clear();
+        bool seam = false;
+
+        for (int f : vertex_faces[from]) {
+            if (!face_alive[f] || !has_vertex(faces[f], to))
+                continue;
+
+            int from_t = faces[f].t_index[corner_of(faces[f], from)];
+            int to_t = faces[f].t_index[corner_of(faces[f], to)];
+            int mapped = mapped_text_coord(from_t);
+
+            if (mapped == -1)
+                text_coord_map.push_back({ from_t, to_t });
+            else if (mapped != to_t)
+                seam = true;
+        }
+
+        for (int f : vertex_faces[from]) {
+            if (face_alive[f] && !has_vertex(faces[f], to)
+                    && mapped_text_coord(faces[f].t_index[corner_of(faces[f], from)]) == -1)
+                seam = true;
+        }
+
+        if (seam)
+            continue;
+
+        for (int f : vertex_faces[from]) {
+            if (!face_alive[f])
+                continue;
+
+            if (has_vertex(faces[f], to)) {
+                face_alive[f] = false;
+                live_faces--;
+                continue;
+            }
+
+            for (int j = 0; j < 3; j++) {
+                if (faces[f].v_index[j] == from) {
+                    faces[f].v_index[j] = to;
+                    faces[f].t_index[j] = mapped_text_coord(faces[f].t_index[j]);
+                }
+            }
+
+            vertex_faces[to].push_back(f);
+        }
+
+        collapsed_into[from] = to;
+        quadrics[to] = quadrics[to] + quadrics[from];
+        versions[to]++;
+
+        vertex_faces[from].clear();
+
+        // the costs of every edge around the merged vertex changed
+        for (int f : vertex_faces[to]) {
+            if (!face_alive[f])
+                continue;
+
+            for (int j = 0; j < 3; j++) {
+                int neighbour = faces[f].v_index[j];
+                if (neighbour != to)
+                    push_edge(to, neighbour);
+            }
+        }
+    }
+
+    std::vector<MdePoly> result;
+    for (int f = 0; f < num_polys; f++) {
+        if (face_alive[f])
+            result.push_back(faces[f]);
+    }
+
+    return result;
+}
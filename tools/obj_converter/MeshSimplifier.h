@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/io/MdeReader.h"
+
+/*
+ * Quadric error edge collapse (Garland & Heckbert). Vertices are only collapsed onto one of
+ * their neighbours, never onto a new position, so the simplified polygons still index the
+ * vertex list of the full mesh and every frame of an animation can use them.
+ *
+ * Collapses that would flip a polygon are rejected and open borders are held in place by
+ * extra planes, so the result keeps the silhouette of the mesh. Moved corners take the
+ * texture coordinate the target vertex has in the same uv chart, collapses that would carry a
+ * corner across a uv seam are rejected.
+ */
+std::vector<MdePoly> simplify_mesh(const std::vector<MdeVert> &verts, const std::vector<MdePoly> &polys,
+        int target_polys);
@@ -6,19 +6,29 @@
 #include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <atomic>
 
 #include "../../src/io/ObjReader.h"
 #include "../../src/io/MdeReader.h"
 
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
 using std::string;
 using std::vector;
 
-int convert_obj_files(std::string dir, std::string output_path, vector<string> skin_name);
+int convert_obj_files(std::string dir, std::string output_path, vector<string> skin_name, int num_lods, int version);
 bool ends_width(const std::string &full_string, const std::string &ending);
 std::vector<std::string> get_obj_file_paths(std::string path);
 
 bool read_obj_files(vector<string> file_paths, vector<vector<MdeVert>> &total_verts, vector<vector<MdePoly>> &total_polys, vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames);
-bool write_mde_data(string output_path, vector<string> skin_name, vector<vector<MdeVert>> &total_verts, vector<vector<MdePoly>> &total_polys, vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames);
+bool write_mde_data(string output_path, vector<string> skin_name, vector<vector<MdeVert>> &total_verts, vector<vector<MdePoly>> &total_polys, vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames,
+        vector<vector<MdePoly>> &lods);
+bool write_mde_v2_data(string output_path, vector<string> skin_names, vector<vector<MdeVert>> &total_verts, vector<vector<MdePoly>> &total_polys,
+        vector<MdeTextCoord> &text_coords, vector<vector<MdePoly>> &lods);
 
 int main(int argc, char *argv[]) {
     std::vector<std::string> argument_inputs;
@@ -30,6 +40,12 @@ int main(int argc, char *argv[]) {
     std::string output_path;
     vector<string> skin_names;
 
+    // every level of detail has half the polygons of the one before
+    int num_lods = 2;
+
+    // version 1 is still written on request for older builds of the engine
+    int version = MdeVersion2;
+
     for (int i = 1; i < argument_inputs.size(); i++) {
         if (argument_inputs[i] == "-i") {
             input_dir = argument_inputs[i + 1];
@@ -42,15 +58,21 @@ int main(int argc, char *argv[]) {
         if (argument_inputs[i] == "-s") {
             skin_names.push_back(argument_inputs[i + 1]);
         }
-    }
 
-    convert_obj_files(input_dir, output_path, skin_names);
+        if (argument_inputs[i] == "-l") {
+            num_lods = std::stoi(argument_inputs[i + 1]);
+        }
 
-    return 0;
+        if (argument_inputs[i] == "-v") {
+            version = std::stoi(argument_inputs[i + 1]);
+        }
+    }
+
+    return convert_obj_files(input_dir, output_path, skin_names, num_lods, version);
 }
 
 
-int convert_obj_files(std::string path, std::string output_path, vector<string> skin_names) {
+int convert_obj_files(std::string path, std::string output_path, vector<string> skin_names, int num_lods, int version) {
     auto file_paths = get_obj_file_paths(path);
 
     std::vector<std::vector<MdeVert>> total_verts;
@@ -58,72 +80,161 @@ int convert_obj_files(std::string path, std::string output_path, vector<string>
     std::vector<MdeTextCoord> text_coords;
     std::vector<MdeFrame> frames;
 
-    read_obj_files(file_paths, total_verts, total_polys, text_coords, frames);
-    write_mde_data(output_path, skin_names, total_verts, total_polys, text_coords, frames);
+    if (!read_obj_files(file_paths, total_verts, total_polys, text_coords, frames))
+        return 1;
+
+    optimize_mesh(total_verts, total_polys, text_coords);
 
-    return 0;
+    // the levels are simplified on the first frame, the other frames reuse its polygons
+    std::vector<std::vector<MdePoly>> lods;
+    for (int lod = 1; lod <= num_lods; lod++) {
+        int target_polys = total_polys[0].size() >> lod;
+
+        lods.push_back(simplify_mesh(total_verts[0], total_polys[0], target_polys));
+        optimize_poly_order(lods.back(), total_verts[0].size());
+
+        std::cout << "lod " << lod << ": " << lods.back().size() << " polys" << std::endl;
+    }
+
+    bool written;
+    if (version == 1) {
+        written = write_mde_data(output_path, skin_names, total_verts, total_polys, text_coords, frames, lods);
+    } else {
+        written = write_mde_v2_data(output_path, skin_names, total_verts, total_polys, text_coords, lods);
+    }
+
+    return written ? 0 : 1;
 }
 
-bool read_obj_files(vector<string> file_paths, vector<vector<MdeVert>> &total_verts,
-        vector<vector<MdePoly>> &total_polys, vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames)
-{
+struct ObjFrame {
+    vector<MdeVert> verts;
+    vector<MdePoly> polys;
+    vector<MdeTextCoord> text_coords;
+
+    // empty when the frame was read and is consistent in itself
+    string error;
+};
+
+static void convert_obj_frame(const string &file_path, ObjFrame &frame) {
     ObjReader reader;
 
-    auto i = 0;
-    bool first = true;
-    for (const auto &file_path : file_paths) {
-        if (!reader.read_file(file_path)) {
-            return false;
-        }
+    // the frames are already spread over the threads
+    if (!reader.read_file(file_path, 1)) {
+        frame.error = "could not be read";
+        return;
+    }
 
-        std::vector<MdeVert> verts;
-        for (const auto &vert : reader.m_vertices)
-            verts.push_back(MdeVert {vert.x, vert.y, vert.z});
+    for (const auto &vert : reader.m_vertices)
+        frame.verts.push_back(MdeVert {vert.x, vert.y, vert.z});
 
-        total_verts.push_back(verts);
+    for (const auto &text_coord : reader.m_tex_coords)
+        frame.text_coords.push_back(MdeTextCoord {text_coord.x, text_coord.y });
 
-        if (first) {
-            for (const auto &text_coord : reader.m_tex_coords)
-                text_coords.push_back(MdeTextCoord {text_coord.x, text_coord.y });
+    int num_verts = reader.m_vertices.size();
+    int num_text_coords = reader.m_tex_coords.size();
 
-            first = false;
-        }
+    // the polys store 16 bit indices in both versions of the format
+    if (num_verts > UINT16_MAX + 1 || num_text_coords > UINT16_MAX + 1) {
+        frame.error = "has more than " + std::to_string(UINT16_MAX + 1) + " vertices or texture coordinates";
+        return;
+    }
 
-        std::vector<MdePoly> polys;
-        for (int i = 0; i < reader.m_indices.size(); i+= 3) {
-            MdePoly poly;
+    for (int i = 0; i < reader.m_indices.size(); i+= 3) {
+        MdePoly poly {};
 
-            for (int j = 0; j < 3; j++) {
-                auto current_index = reader.m_indices[i + j];
+        for (int j = 0; j < 3; j++) {
+            auto current_index = reader.m_indices[i + j];
 
-                poly.v_index[j] = current_index.vertex_index;
+            if (current_index.vertex_index < 0 || current_index.vertex_index >= num_verts) {
+                frame.error = "face " + std::to_string(i / 3) + " references a missing vertex";
+                return;
+            }
 
-                if (reader.has_tex_coords) {
-                    poly.t_index[j] = current_index.tex_coord_index;
-                }
+            poly.v_index[j] = current_index.vertex_index;
 
-                // TODO also set the normal index
-                if (reader.has_normal_indices) {
-                    poly.normal_index = current_index.normal_index;
+            if (reader.has_tex_coords) {
+                if (current_index.tex_coord_index < 0 || current_index.tex_coord_index >= num_text_coords) {
+                    frame.error = "face " + std::to_string(i / 3) + " references a missing texture coordinate";
+                    return;
                 }
+
+                poly.t_index[j] = current_index.tex_coord_index;
             }
 
-            polys.push_back(poly);
+            // TODO also set the normal index
+            if (reader.has_normal_indices) {
+                poly.normal_index = current_index.normal_index;
+            }
         }
 
-        total_polys.push_back(polys);
-        frames.push_back(MdeFrame{});
+        frame.polys.push_back(poly);
+    }
+}
+
+bool read_obj_files(vector<string> file_paths, vector<vector<MdeVert>> &total_verts,
+        vector<vector<MdePoly>> &total_polys, vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames)
+{
+    int num_frames = file_paths.size();
+    if (num_frames == 0) {
+        std::cout << "No obj files found" << std::endl;
+        return false;
+    }
+
+    vector<ObjFrame> obj_frames(num_frames);
+
+    // every worker takes the next frame that nobody works on yet
+    std::atomic<int> next_frame {0};
 
-        std::cout << file_path << std::endl;
+    auto worker = [&] {
+        for (int frame = next_frame++; frame < num_frames; frame = next_frame++)
+            convert_obj_frame(file_paths[frame], obj_frames[frame]);
+    };
+
+    int num_threads = std::min<int>(num_frames, std::max(1u, std::thread::hardware_concurrency()));
+
+    vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (auto &thread : threads)
+        thread.join();
+
+    // merged in order, every frame has to share the topology of the first one
+    size_t num_verts = obj_frames[0].verts.size();
+    size_t num_polys = obj_frames[0].polys.size();
+
+    for (int frame = 0; frame < num_frames; frame++) {
+        auto &obj_frame = obj_frames[frame];
+
+        if (obj_frame.error.empty()) {
+            if (obj_frame.verts.size() != num_verts)
+                obj_frame.error = "has a different amount of vertices than the first frame";
+            else if (obj_frame.polys.size() != num_polys)
+                obj_frame.error = "has a different amount of faces than the first frame";
+        }
 
-        i++;
+        if (!obj_frame.error.empty()) {
+            std::cout << file_paths[frame] << ": " << obj_frame.error << std::endl;
+            return false;
+        }
+
+        if (frame == 0)
+            text_coords = std::move(obj_frame.text_coords);
+
+        total_verts.push_back(std::move(obj_frame.verts));
+        total_polys.push_back(std::move(obj_frame.polys));
+        frames.push_back(MdeFrame{});
+
+        std::cout << file_paths[frame] << std::endl;
     }
 
     return true;
 }
 
 bool write_mde_data(string output_path, vector<string> skin_names, vector<vector<MdeVert>> &total_verts, vector<vector<MdePoly>> &total_polys,
-        vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames)
+        vector<MdeTextCoord> &text_coords, vector<MdeFrame> &frames, vector<vector<MdePoly>> &lods)
 {
     MdeHeader header;
 
@@ -166,10 +277,192 @@ bool write_mde_data(string output_path, vector<string> skin_names, vector<vector
 
     fs.write(reinterpret_cast<char*>(&frames[0]), frames.size() * sizeof(MdeFrame));
 
+    if (!lods.empty()) {
+        int num_lods = lods.size();
+
+        fs.write(MdeLodsTag, sizeof(MdeLodsTag));
+        fs.write(reinterpret_cast<char*>(&num_lods), sizeof(num_lods));
+
+        for (auto &lod : lods) {
+            int num_polys = lod.size();
+
+            fs.write(reinterpret_cast<char*>(&num_polys), sizeof(num_polys));
+            fs.write(reinterpret_cast<char*>(lod.data()), lod.size() * sizeof(MdePoly));
+        }
+    }
+
+    if (!fs.is_open()) {
+        return false;
+    }
+
+    fs.close();
+
+    return true;
+}
+
+/* same normals as the engine computed at load time: the sum of the faces around the vertex */
+static vector<MdeVert> compute_vertex_normals(const vector<MdeVert> &verts, const vector<MdePoly> &polys) {
+    vector<MdeVert> normals(verts.size(), MdeVert {0, 0, 0});
+
+    for (const auto &poly : polys) {
+        auto &v0 = verts[poly.v_index[0]].v;
+        auto &v1 = verts[poly.v_index[1]].v;
+        auto &v2 = verts[poly.v_index[2]].v;
+
+        V4D line1(v0[0] - v1[0], v0[1] - v1[1], v0[2] - v1[2]);
+        V4D line2(v0[0] - v2[0], v0[1] - v2[1], v0[2] - v2[2]);
+        auto n = line1.cross(line2);
+
+        for (int j = 0; j < 3; j++) {
+            auto &normal = normals[poly.v_index[j]].v;
+            normal[0] += n.x;
+            normal[1] += n.y;
+            normal[2] += n.z;
+        }
+    }
+
+    for (auto &normal : normals) {
+        float length = std::sqrt(normal.v[0] * normal.v[0] + normal.v[1] * normal.v[1] + normal.v[2] * normal.v[2]);
+
+        if (length > 0) {
+            normal.v[0] /= length;
+            normal.v[1] /= length;
+            normal.v[2] /= length;
+        }
+    }
+
+    return normals;
+}
+
+bool write_mde_v2_data(string output_path, vector<string> skin_names, vector<vector<MdeVert>> &total_verts, vector<vector<MdePoly>> &total_polys,
+        vector<MdeTextCoord> &text_coords, vector<vector<MdePoly>> &lods)
+{
+    if (total_verts[0].size() > UINT16_MAX + 1 || text_coords.size() > UINT16_MAX + 1) {
+        std::cout << "Version 2 indices are 16 bit, the mesh may have at most " << UINT16_MAX + 1
+            << " vertices and texture coordinates" << std::endl;
+        return false;
+    }
+
+    MdeHeaderV2 header {};
+
+    header.version = MdeVersion2;
+    std::memcpy(header.magic, MdeMagic, sizeof(MdeMagic));
+
+    header.num_skins = skin_names.size();
+    header.num_verts = total_verts[0].size();
+    header.num_textcoords = text_coords.size();
+    header.num_frames = total_verts.size();
+    header.num_blocks = lods.size() + 1;
+
+    vector<char> data(sizeof(MdeHeaderV2));
+
+    auto add_section = [&data](const void *section_data, size_t size) {
+        data.resize((data.size() + MdeAlignment - 1) / MdeAlignment * MdeAlignment);
+
+        MdeSection section { (uint32_t)data.size(), (uint32_t)size };
+        data.insert(data.end(), (const char*)section_data, (const char*)section_data + size);
+
+        return section;
+    };
+
+    vector<char> skins(header.num_skins * 64, '\0');
+    for (int i = 0; i < header.num_skins; i++)
+        std::strncpy(&skins[i * 64], skin_names[i].c_str(), 63);
+
+    header.skins = add_section(skins.data(), skins.size());
+
+    // split the vertices into one array per component, frame after frame
+    vector<float> components[6];
+    for (int i = 0; i < 3; i++) {
+        header.bounds_min[i] = INFINITY;
+        header.bounds_max[i] = -INFINITY;
+    }
+
+    for (const auto &verts : total_verts) {
+        auto normals = compute_vertex_normals(verts, total_polys[0]);
+
+        for (int ivert = 0; ivert < header.num_verts; ivert++) {
+            auto &v = verts[ivert].v;
+
+            for (int i = 0; i < 3; i++) {
+                components[i].push_back(v[i]);
+                components[3 + i].push_back(normals[ivert].v[i]);
+
+                header.bounds_min[i] = std::min(header.bounds_min[i], v[i]);
+                header.bounds_max[i] = std::max(header.bounds_max[i], v[i]);
+            }
+
+            header.radius = std::max(header.radius, std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        header.positions[i] = add_section(components[i].data(), components[i].size() * sizeof(float));
+        header.normals[i] = add_section(components[3 + i].data(), components[3 + i].size() * sizeof(float));
+    }
+
+    vector<float> us, vs;
+    for (const auto &text_coord : text_coords) {
+        us.push_back(text_coord.u);
+        vs.push_back(text_coord.v);
+    }
+
+    header.text_coords[0] = add_section(us.data(), us.size() * sizeof(float));
+    header.text_coords[1] = add_section(vs.data(), vs.size() * sizeof(float));
+
+    // block 0 is the full mesh, the levels of detail follow
+    vector<MdePolyBlock> blocks;
+    vector<const vector<MdePoly>*> block_polys = { &total_polys[0] };
+    for (const auto &lod : lods)
+        block_polys.push_back(&lod);
+
+    auto &first_frame = total_verts[0];
+
+    for (auto polys : block_polys) {
+        MdePolyBlock block {};
+        block.num_polys = polys->size();
+
+        vector<uint16_t> vertex_indices, text_indices;
+        vector<float> face_normals[3];
+
+        for (const auto &poly : *polys) {
+            for (int j = 0; j < 3; j++) {
+                vertex_indices.push_back(poly.v_index[j]);
+                text_indices.push_back(poly.t_index[j]);
+            }
+
+            auto &v0 = first_frame[poly.v_index[0]].v;
+            auto &v1 = first_frame[poly.v_index[1]].v;
+            auto &v2 = first_frame[poly.v_index[2]].v;
+
+            V4D line1(v0[0] - v1[0], v0[1] - v1[1], v0[2] - v1[2]);
+            V4D line2(v0[0] - v2[0], v0[1] - v2[1], v0[2] - v2[2]);
+            auto n = line1.cross(line2);
+
+            face_normals[0].push_back(n.x);
+            face_normals[1].push_back(n.y);
+            face_normals[2].push_back(n.z);
+        }
+
+        block.vertex_indices = add_section(vertex_indices.data(), vertex_indices.size() * sizeof(uint16_t));
+        block.text_indices = add_section(text_indices.data(), text_indices.size() * sizeof(uint16_t));
+
+        for (int i = 0; i < 3; i++)
+            block.face_normals[i] = add_section(face_normals[i].data(), face_normals[i].size() * sizeof(float));
+
+        blocks.push_back(block);
+    }
+
+    header.blocks = add_section(blocks.data(), blocks.size() * sizeof(MdePolyBlock));
+
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    std::ofstream fs(output_path, std::ios::out | std::ios::binary);
     if (!fs.is_open()) {
         return false;
     }
 
+    fs.write(data.data(), data.size());
     fs.close();
 
     return true;
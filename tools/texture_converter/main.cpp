@@ -0,0 +1,121 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "../../src/graphics/Texture.h"
+#include "../../src/io/MtcReader.h"
+
+using std::string;
+using std::vector;
+
+bool convert_texture(string input_path, string output_path, float gamma);
+bool write_mtc_data(string output_path, const Graphics::MipTexturesList &mip_textures);
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> argument_inputs;
+
+    for (int i = 0; i < argc; i++)
+        argument_inputs.push_back(std::string(argv[i]));
+
+    std::string input_path;
+    std::string output_path;
+
+    // the engine filters its mip levels with the same gamma
+    float gamma = 1.01f;
+
+    for (size_t i = 1; i < argument_inputs.size(); i++) {
+        if (argument_inputs[i] == "-i") {
+            input_path = argument_inputs[i + 1];
+        }
+
+        if (argument_inputs[i] == "-o") {
+            output_path = argument_inputs[i + 1];
+        }
+
+        if (argument_inputs[i] == "-g") {
+            gamma = std::stof(argument_inputs[i + 1]);
+        }
+    }
+
+    if (input_path.empty() || output_path.empty()) {
+        printf("Usage: texture_converter -i <texture.bmp> -o <texture.mtc> [-g <gamma>]\n");
+        return 1;
+    }
+
+    return convert_texture(input_path, output_path, gamma) ? 0 : 1;
+}
+
+bool convert_texture(string input_path, string output_path, float gamma) {
+    Graphics::MipTexturesList mip_textures;
+
+    auto root_texture = new Graphics::Texture();
+    if (!root_texture->load_from_bmp(input_path)) {
+        printf("Could not load bmp %s\n", input_path.c_str());
+        delete root_texture;
+        return false;
+    }
+
+    mip_textures.push_back(std::unique_ptr<Graphics::Texture>(root_texture));
+
+    // same chain as Assets::load_texture builds at load time
+    auto mip_levels = std::log(root_texture->width) / std::log(2) + 1;
+
+    for (int mip_level = 1; mip_level < mip_levels; mip_level++) {
+        auto quarter_texture = mip_textures[mip_level - 1]->quarter_size(gamma);
+        mip_textures.push_back(std::move(quarter_texture));
+    }
+
+    if (!write_mtc_data(output_path, mip_textures)) {
+        printf("Could not write %s\n", output_path.c_str());
+        return false;
+    }
+
+    printf("%s: %zu levels\n", output_path.c_str(), mip_textures.size());
+
+    return true;
+}
+
+bool write_mtc_data(string output_path, const Graphics::MipTexturesList &mip_textures) {
+    MtcHeader header {};
+
+    std::memcpy(header.magic, MtcMagic, sizeof(MtcMagic));
+    header.version = MtcVersion;
+    header.num_levels = mip_textures.size();
+
+    vector<MtcLevel> levels;
+    uint32_t offset = sizeof(MtcHeader) + sizeof(MtcLevel) * header.num_levels;
+
+    for (const auto &texture : mip_textures) {
+        offset = (offset + MtcAlignment - 1) / MtcAlignment * MtcAlignment;
+
+        MtcLevel level;
+        level.width = texture->width;
+        level.height = texture->height;
+        level.offset = offset;
+        level.size = texture->width * texture->height * sizeof(uint32_t);
+
+        levels.push_back(level);
+        offset += level.size;
+    }
+
+    vector<char> data(offset, 0);
+
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), levels.data(), levels.size() * sizeof(MtcLevel));
+
+    for (int i = 0; i < header.num_levels; i++)
+        std::memcpy(data.data() + levels[i].offset, mip_textures[i]->get_pixels(), levels[i].size);
+
+    std::ofstream fs(output_path, std::ios::out | std::ios::binary);
+    if (!fs.is_open()) {
+        return false;
+    }
+
+    fs.write(data.data(), data.size());
+    fs.close();
+
+    return true;
+}